@@ -0,0 +1,194 @@
+#include "graph.hpp"
+#include "bicoloredGraph.hpp"
+#include "EIS_sample.hpp"
+#include "tabulation_hashing.hpp"
+#include "generators.hpp"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <map>
+#include <numeric>
+#include <unordered_set>
+
+// Micro-benchmarks of the hot kernels on synthetic Chung-Lu graphs.
+// Graph arguments are {number of nodes, 10 * power-law exponent}; smaller exponents mean more skew.
+
+static const std::vector<Graph::edge>& syntheticEdges(const benchmark::State& state)
+{
+    static std::map<std::pair<int64_t, int64_t>, std::vector<Graph::edge>> cache;
+    auto key = std::make_pair(state.range(0), state.range(1));
+    auto it = cache.find(key);
+    if (it == cache.end()) {
+        GraphGenerator::Config config;
+        config.model = GraphGenerator::Model::ChungLu;
+        config.n = state.range(0);
+        config.m = 4 * state.range(0);
+        config.exponent = state.range(1) / 10.0;
+        config.seed = 42;
+        it = cache.emplace(key, GraphGenerator(config).generate()).first;
+    }
+    return it->second;
+}
+
+static Graph syntheticGraph(const benchmark::State& state)
+{
+    Graph graph;
+    for (auto [u, v] : syntheticEdges(state)) {
+        graph.addEdge(u, v, true);
+    }
+    return graph;
+}
+
+// Color 0: uniform sample of a quarter of the edges, color 1: all edges induced by its nodes
+static BiColoredGraph syntheticBiColoredGraph(const benchmark::State& state)
+{
+    const auto& edges = syntheticEdges(state);
+    BiColoredGraph graph;
+    std::unordered_set<int> sampled;
+    for (size_t i = 0; i < edges.size(); i += 4) {
+        graph.addEdge(edges[i].first, edges[i].second, 0);
+        sampled.insert(edges[i].first);
+        sampled.insert(edges[i].second);
+    }
+    for (auto [u, v] : edges) {
+        if (sampled.contains(u) and sampled.contains(v)) graph.addEdge(u, v, 1);
+    }
+    return graph;
+}
+
+static void syntheticArgs(benchmark::internal::Benchmark* b)
+{
+    for (int n : {1 << 12, 1 << 15}) {
+        for (int exponent : {21, 25, 30}) {
+            b->Args({n, exponent});
+        }
+    }
+}
+
+
+static void BM_TabHashSimple(benchmark::State& state)
+{
+    TabHash hash;
+    uint32_t x = 0, h = 0;
+    for (auto _ : state) {
+        h ^= hash.Simple(x++);
+    }
+    benchmark::DoNotOptimize(h);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TabHashSimple);
+
+static void BM_TabHashTwisted(benchmark::State& state)
+{
+    TabHash hash;
+    uint32_t x = 0, h = 0;
+    for (auto _ : state) {
+        h ^= hash.Twisted(x++);
+    }
+    benchmark::DoNotOptimize(h);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TabHashTwisted);
+
+static void BM_ProcessForReservoirSampling(benchmark::State& state)
+{
+    const auto& edges = syntheticEdges(state);
+    for (auto _ : state) {
+        Sample sample;
+        sample.setupReservoirSampling(edges.size() / 10);
+        for (const auto& edge : edges) {
+            sample.processForReservoirSampling(edge);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * edges.size());
+}
+BENCHMARK(BM_ProcessForReservoirSampling)->Apply(syntheticArgs);
+
+static void BM_CollectInducedEdge(benchmark::State& state)
+{
+    const auto& edges = syntheticEdges(state);
+    for (auto _ : state) {
+        state.PauseTiming();
+        Sample sample;
+        sample.setupReservoirSampling(edges.size() / 10);
+        for (const auto& edge : edges) {
+            sample.processForReservoirSampling(edge);
+        }
+        sample.finalizeReservoirSampling();
+        state.ResumeTiming();
+        for (const auto& edge : edges) {
+            sample.collectInducedEge(edge);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * edges.size());
+}
+BENCHMARK(BM_CollectInducedEdge)->Apply(syntheticArgs);
+
+// Removes the 1% highest degree nodes
+static void BM_BiColoredRemoveNode(benchmark::State& state)
+{
+    const BiColoredGraph original = syntheticBiColoredGraph(state);
+    std::vector<int> nodes(original.n_max());
+    std::iota(nodes.begin(), nodes.end(), 0);
+    std::sort(nodes.begin(), nodes.end(), [&](int a, int b) { return original.degree(a) > original.degree(b); });
+    nodes.resize(std::max<size_t>(1, nodes.size() / 100));
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        BiColoredGraph graph = original;
+        state.ResumeTiming();
+        for (int u : nodes) {
+            graph.removeNode(u);
+        }
+        benchmark::DoNotOptimize(graph.m());
+    }
+    state.SetItemsProcessed(state.iterations() * nodes.size());
+}
+BENCHMARK(BM_BiColoredRemoveNode)->Apply(syntheticArgs);
+
+static void BM_BiColoredChibaNishizeki(benchmark::State& state)
+{
+    BiColoredGraph graph = syntheticBiColoredGraph(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(graph.BiColoredChibaNishizeki());
+    }
+    state.SetItemsProcessed(state.iterations() * graph.m());
+}
+BENCHMARK(BM_BiColoredChibaNishizeki)->Apply(syntheticArgs)->Unit(benchmark::kMillisecond);
+
+static void BM_ChibaNishizeki(benchmark::State& state)
+{
+    Graph graph = syntheticGraph(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(graph.ChibaNishizeki());
+    }
+    state.SetItemsProcessed(state.iterations() * graph.m());
+}
+BENCHMARK(BM_ChibaNishizeki)->Apply(syntheticArgs)->Unit(benchmark::kMillisecond);
+
+static void BM_CountFourCycles(benchmark::State& state)
+{
+    Graph graph = syntheticGraph(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(graph.countFourCycles().total);
+    }
+    state.SetItemsProcessed(state.iterations() * graph.m());
+}
+BENCHMARK(BM_CountFourCycles)->Apply(syntheticArgs)->Unit(benchmark::kMillisecond);
+
+static void BM_CountSquaresCompletedByEdge(benchmark::State& state)
+{
+    Graph graph = syntheticGraph(state);
+    const auto& edges = graph.edges();
+    size_t i = 0;
+    for (auto _ : state) {
+        auto [u, v] = edges[i];
+        benchmark::DoNotOptimize(graph.countSquaresCompletedByEdge(u, v));
+        i = (i + 1) % edges.size();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CountSquaresCompletedByEdge)->Apply(syntheticArgs);
+
+BENCHMARK_MAIN();
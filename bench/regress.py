@@ -0,0 +1,163 @@
+#!/usr/bin/env python3
+"""End-to-end performance regression harness.
+
+Runs the estimators over the matrix in bench/matrix.json, records throughput,
+latency percentiles, peak memory and estimator error per configuration and
+compares them against the committed baseline (bench/baseline.json).
+Exits non-zero if any configuration got slower than the threshold allows or
+its estimator error grew by more than the error threshold.
+
+Works offline: graphs are either files (e.g. data/out.caida) or generated
+with the gen executable.
+
+    bench/regress.py --build build                    # run and compare
+    bench/regress.py --build build --update-baseline  # record a new baseline
+"""
+
+import argparse
+import json
+import os
+import statistics
+import subprocess
+import sys
+
+BENCH_DIR = os.path.dirname(os.path.abspath(__file__))
+ROOT_DIR = os.path.dirname(BENCH_DIR)
+
+
+def run_json(cmd):
+    out = subprocess.run(cmd, check=True, capture_output=True, text=True).stdout
+    return json.loads(out)
+
+
+def prepare_graph(build, graph, workdir):
+    """Returns the path of the graph, generating it if needed."""
+    if "file" in graph:
+        return os.path.join(ROOT_DIR, graph["file"])
+    path = os.path.join(workdir, graph["name"] + ".bin")
+    if not os.path.exists(path):
+        cmd = [os.path.join(build, "gen"), path, "--format", "binary"]
+        for key, value in graph["gen"].items():
+            cmd += [("-" if len(key) == 1 else "--") + key, str(value)]
+        subprocess.run(cmd, check=True, capture_output=True)
+    return path
+
+
+def configurations(matrix):
+    for algo in matrix["algorithms"]:
+        for k in matrix["k"]:
+            for s in (matrix["s"] if algo == "EISm" else [1]):
+                for threads in matrix["threads"]:
+                    yield algo, k, s, threads
+
+
+def measure(build, path, exact, algo, k, s, threads, reps, seed):
+    report = run_json([os.path.join(build, algo), path, "-k", str(k), "-s", str(s), "-r", str(reps),
+                       "--threads", str(threads), "--seed", str(seed), "--report=json"])
+    timer = report["timers"][algo]
+    estimates = [float(e) for e in report["estimates"]]
+    errors = [abs(e - exact) / exact for e in estimates] if exact > 0 else [0.0]
+    return {
+        "edges_per_second": report["edges_per_second"],
+        "latency_min_ns": timer["min_ns"],
+        "latency_median_ns": timer["median_ns"],
+        "latency_p99_ns": timer["p99_ns"],
+        "latency_mean_ns": timer["total_ns"] / timer["count"],
+        "peak_rss_bytes": report["peak_rss_bytes"],
+        "mean_relative_error": statistics.mean(errors),
+    }
+
+
+def slowdown(current, base):
+    return current["latency_min_ns"] / base["latency_min_ns"] - 1
+
+
+def compare(results, baseline, threshold, error_threshold):
+    """Prints the comparison, returns the number of regressions beyond the thresholds.
+
+    Slowdowns are judged on the fastest repetition, which is the least sensitive to noise
+    from other processes. Errors are judged by the absolute increase of the mean relative
+    error; with the fixed seed of the matrix they only change with the estimators.
+    Memory changes are reported but never fail the run.
+    """
+    failures = 0
+    print(f"{'configuration':48} {'latency':>12} {'baseline':>12} {'change':>8} {'rss':>8} {'error':>8}")
+    for key, current in sorted(results.items()):
+        base = baseline.get(key)
+        if base is None:
+            print(f"{key:48} {current['latency_min_ns'] / 1e6:10.1f}ms {'-':>12} {'new':>8}")
+            continue
+        change = slowdown(current, base)
+        rss = current["peak_rss_bytes"] / base["peak_rss_bytes"] - 1
+        error = current["mean_relative_error"] - base["mean_relative_error"]
+        flag = ""
+        if change > threshold:
+            flag += "  SLOWER"
+        if error > error_threshold:
+            flag += "  LESS ACCURATE"
+        if flag:
+            failures += 1
+        print(f"{key:48} {current['latency_min_ns'] / 1e6:10.1f}ms {base['latency_min_ns'] / 1e6:10.1f}ms "
+              f"{change:+8.1%} {rss:+8.1%} {error:+8.3f}{flag}")
+    return failures
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--build", default=os.path.join(ROOT_DIR, "build"), help="directory with the executables")
+    parser.add_argument("--matrix", default=os.path.join(BENCH_DIR, "matrix.json"))
+    parser.add_argument("--baseline", default=os.path.join(BENCH_DIR, "baseline.json"))
+    parser.add_argument("--output", default="bench_results.json", help="results file")
+    parser.add_argument("--threshold", type=float, default=0.2, help="allowed relative slowdown")
+    parser.add_argument("--error-threshold", type=float, default=0.02,
+                        help="allowed absolute increase of the mean relative error")
+    parser.add_argument("--retries", type=int, default=2, help="re-measurements of configurations that look slower")
+    parser.add_argument("--update-baseline", action="store_true", help="write the results as new baseline")
+    args = parser.parse_args()
+
+    with open(args.matrix) as f:
+        matrix = json.load(f)
+    workdir = os.path.join(args.build, "bench_graphs")
+    os.makedirs(workdir, exist_ok=True)
+
+    baseline = {}
+    if not args.update_baseline:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+
+    results = {}
+    for graph in matrix["graphs"]:
+        path = prepare_graph(args.build, graph, workdir)
+        exact = float(run_json([os.path.join(args.build, "exact"), path, "-r", "1", "--report=json"])["estimates"][0])
+        for algo, k, s, threads in configurations(matrix):
+            key = f"{graph['name']}/{algo}/k={k}/s={s}/t={threads}"
+            print(f"running {key}", file=sys.stderr)
+            run = lambda: measure(args.build, path, exact, algo, k, s, threads, matrix["reps"], matrix["seed"])
+            results[key] = run()
+            # Suspected slowdowns are measured again and the fastest run is kept, to filter out noise
+            for _ in range(args.retries):
+                if key not in baseline or slowdown(results[key], baseline[key]) <= args.threshold:
+                    break
+                print(f"re-running {key}", file=sys.stderr)
+                results[key] = min(results[key], run(), key=lambda r: r["latency_min_ns"])
+
+    with open(args.output, "w") as f:
+        json.dump(results, f, indent=2, sort_keys=True)
+
+    if args.update_baseline:
+        with open(args.baseline, "w") as f:
+            json.dump(results, f, indent=2, sort_keys=True)
+            f.write("\n")
+        print(f"baseline written to {args.baseline}")
+        return 0
+
+    failures = compare(results, baseline, args.threshold, args.error_threshold)
+    if failures:
+        print(f"{failures} configuration(s) slower than the baseline by more than {args.threshold:.0%} "
+              f"or with an error larger by more than {args.error_threshold}")
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -1,10 +1,14 @@
 #ifndef EIS_SAMPLE_HPP
 #define EIS_SAMPLE_HPP
 
+#include <istream>
+#include <ostream>
 #include <unordered_map>
 #include <vector>
 #include <random>
 #include "bicoloredGraph.hpp"
+#include "basics/sample_stats.hpp"
+#include "basics/wide_count.hpp"
 
 struct Sample {
     using node = int;
@@ -15,7 +19,26 @@ struct Sample {
     void processForReservoirSampling(edge edge);
     void finalizeReservoirSampling();
     void collectInducedEge(edge edge);
-    long long estimate();
+    // Fully dynamic streams: the first pass happens elsewhere (RandomPairingReservoir); its sample of
+    // the streamsize edges left at the end is shuffled and used like a finished reservoir of the given space
+    void setupFromReservoir(const std::vector<edge>& edges, int space, int streamsize);
+    // Insertion (sign > 0) or deletion of an edge in the second pass
+    void collectInducedUpdate(edge edge, int sign);
+    // Sharded streams (see Sketch). Before finalizeReservoirSampling(), merging combines the reservoirs
+    // of two disjoint parts of the stream into a uniform reservoir of the whole. After it, both samples
+    // must be copies of the same merged reservoir, and the edges they collected in their second pass
+    // over different parts are combined.
+    void merge(const Sample& other);
+    void write(std::ostream& out) const;
+    void read(std::istream& in);
+    // If localEstimates is given, it receives an estimate for every node with sampled edges (original ids)
+    Estimate estimate(std::unordered_map<node, double>* localEstimates = nullptr);
+    // Counts the sample without estimating or recording to MemoryTracker and returns the heap bytes
+    // of the counting scratch space
+    size_t countingScratch();
+    // Heap bytes of the reservoir, the node mapping and the sampled graph
+    size_t memory_usage() const;
+    SampleStats stats() const;
 
 private:
     BiColoredGraph graph;
@@ -23,12 +46,16 @@ private:
     std::vector<std::pair<node, node>> reservoir;
     node nextNode = 0;
     int processedEdges = 0;
-    std::random_device rd;
     std::minstd_rand gen;
     int space;
     int removedNodes = 0;
     int removedsampledEdges = 0;
     int streamsize = 0;
+    bool finalized = false;
+    void mergeReservoir(const Sample& other);
+    void dropLastSampledEdge();
+    // Edges collected in the second pass, in original ids
+    std::vector<edge> inducedEdges() const;
     inline node getMappedNode(node original) {
         auto it = nodeMapping.find(original);
         if (it == nodeMapping.end()) {
@@ -0,0 +1,61 @@
+#ifndef DRIVER_HPP
+#define DRIVER_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <string>
+#include "basics/parms.hpp"
+#include "basics/report.hpp"
+#include "basics/statistics.hpp"
+#include "basics/timer.hpp"
+#include "basics/wide_count.hpp"
+
+// Runs the repetitions of an estimator on the loaded graph and records their estimates.
+// Without --time-budget and --target-rse these are -r repetitions. Otherwise repetitions continue
+// until the next one would end after the deadline (counted from the start of the program) or the
+// relative standard error of the mean reaches the target; -r then only bounds them if given.
+// Anytime runs print the running mean and its confidence interval to stderr after every repetition.
+class Repetitions {
+public:
+    // The standard error of fewer estimates is too unreliable to stop on
+    static constexpr int MinRepetitionsForRSE = 5;
+
+    // Returns the number of repetitions run
+    static int run(const std::string& name, const std::function<EstimatorResult()>& estimator) {
+        const auto timerId = ScopedTimer::intern(name);
+        const double budget = Parms.timeBudget();
+        const double targetRSE = Parms.targetRSE();
+        RunningStats stats;
+        double slowest = 0;
+
+        for (int i = 0; i < Parms.reps(); ++i) {
+            const auto start = std::chrono::steady_clock::now();
+            EstimatorResult result;
+            {
+                ScopedTimer t(timerId);
+                result = estimator();
+            }
+            RunReport::addResult(result);
+            stats.add(result.estimate.value());
+            if (not Parms.anytime()) continue;
+
+            const auto end = std::chrono::steady_clock::now();
+            slowest = std::max(slowest, std::chrono::duration<double>(end - start).count());
+            const double elapsed = std::chrono::duration<double>(end - Parms.startTime()).count();
+            auto [low, high] = stats.confidenceInterval();
+            std::cerr << name << " " << stats.count() << ": mean " << Estimate(stats.mean()) << ", 95% CI ["
+                      << Estimate(low) << ", " << Estimate(high) << "], RSE " << stats.relativeStandardError()
+                      << ", " << elapsed << " s" << std::endl;
+
+            // Equal estimates, e.g. all 0 on a graph without four-cycles, have no relative error to reach
+            if (targetRSE > 0 and stats.count() >= MinRepetitionsForRSE
+                and (stats.standardError() == 0 or stats.relativeStandardError() <= targetRSE)) break;
+            if (budget > 0 and elapsed + slowest > budget) break;
+        }
+        return stats.count();
+    }
+};
+
+#endif //DRIVER_HPP
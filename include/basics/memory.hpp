@@ -0,0 +1,92 @@
+#ifndef MEMORY_HPP
+#define MEMORY_HPP
+
+#include <cstddef>
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// Heap bytes held by the containers used in this code base. Vectors count their capacity,
+// node based containers an estimate of the per-element overhead of libstdc++.
+class Memory {
+public:
+    static constexpr size_t HashNodeOverhead = 2 * sizeof(void*); // next pointer and cached hash
+    static constexpr size_t TreeNodeOverhead = 4 * sizeof(void*); // color, parent and children
+
+    template <class T> static size_t of(const std::vector<T>& v);
+    template <class T> static size_t of(const std::deque<T>& d);
+    template <class T> static size_t of(const std::set<T>& s);
+    template <class T> static size_t of(const std::unordered_set<T>& s);
+    template <class K, class V> static size_t of(const std::unordered_map<K, V>& m);
+};
+
+template <class T> size_t Memory::of(const std::vector<T>& v) {
+    size_t bytes = v.capacity() * sizeof(T);
+    if constexpr (requires(const T& x) { Memory::of(x); }) {
+        for (const auto& x : v) bytes += of(x);
+    }
+    return bytes;
+}
+
+template <class T> size_t Memory::of(const std::deque<T>& d) {
+    // elements live in blocks of 512 bytes
+    return (d.size() * sizeof(T) / 512 + 1) * 512;
+}
+
+template <class T> size_t Memory::of(const std::set<T>& s) {
+    return s.size() * (sizeof(T) + TreeNodeOverhead);
+}
+
+template <class T> size_t Memory::of(const std::unordered_set<T>& s) {
+    return s.bucket_count() * sizeof(void*) + s.size() * (sizeof(T) + HashNodeOverhead);
+}
+
+template <class K, class V> size_t Memory::of(const std::unordered_map<K, V>& m) {
+    size_t bytes = m.bucket_count() * sizeof(void*) + m.size() * (sizeof(std::pair<const K, V>) + HashNodeOverhead);
+    if constexpr (requires(const V& x) { Memory::of(x); }) {
+        for (const auto& [key, value] : m) bytes += of(value);
+    }
+    return bytes;
+}
+
+// Peak memory per subsystem, reported next to the peak RSS of the process.
+// Subsystems record their footprint at the points where it is largest.
+class MemoryTracker {
+public:
+    static void record(const std::string& subsystem, size_t bytes) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        size_t& peak = _peaks[subsystem];
+        if (bytes > peak) peak = bytes;
+    }
+
+    static std::map<std::string, size_t> peaks() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _peaks;
+    }
+
+    static std::string format(size_t bytes) {
+        const char* units[] = {"B", "KiB", "MiB", "GiB", "TiB"};
+        double value = bytes;
+        int unit = 0;
+        while (value >= 1024 and unit < 4) {
+            value /= 1024;
+            unit++;
+        }
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), unit ? "%.1f %s" : "%.0f %s", value, units[unit]);
+        return buffer;
+    }
+
+private:
+    static inline std::mutex _mutex;
+    static inline std::map<std::string, size_t> _peaks;
+};
+
+#endif //MEMORY_HPP
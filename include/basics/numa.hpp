@@ -0,0 +1,87 @@
+#ifndef NUMA_HPP
+#define NUMA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#ifdef USE_NUMA
+#include <numa.h>
+#endif
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Data placement and thread pinning on machines with several NUMA nodes (sockets), via libnuma if
+// the build found it. Without libnuma, on a single node, or if the kernel does not support NUMA
+// policies, every call does nothing, so callers need no special cases.
+// OpenMP thread t of T runs on node t * nodes / T (nodeOf): consecutive threads share a node, which
+// matches the blocks of schedule(static) loops. Data first touched inside such a loop by its
+// thread therefore stays on the node of the thread that works on it in later loops of the same kind.
+class Numa {
+public:
+    static bool enabled() {
+#ifdef USE_NUMA
+        static const bool enabled = numa_available() >= 0 and numa_num_configured_nodes() > 1;
+        return enabled;
+#else
+        return false;
+#endif
+    }
+
+    static int nodes() {
+#ifdef USE_NUMA
+        if (enabled()) return numa_num_configured_nodes();
+#endif
+        return 1;
+    }
+
+    // Node of the i-th of count threads or processes, in blocks of consecutive ones
+    static int nodeOf(int i, int count) {
+        return count > 0 ? static_cast<int>(1LL * i * nodes() / count) : 0;
+    }
+
+    // Pins every thread of the OpenMP pool to its node. The pool keeps its threads, so this lasts
+    // for all later parallel regions with the same number of threads.
+    static void pinThreads() {
+#if defined(USE_NUMA) && defined(_OPENMP)
+        if (not enabled()) return;
+        #pragma omp parallel
+        numa_run_on_node(nodeOf(omp_get_thread_num(), omp_get_num_threads()));
+#endif
+    }
+
+    // Runs the calling process on the node and prefers its memory for allocations, e.g. for one of
+    // several worker processes. Threads started afterwards inherit this.
+    static void bindProcess(int node) {
+#ifdef USE_NUMA
+        if (not enabled()) return;
+        numa_run_on_node(node);
+        numa_set_preferred(node);
+#endif
+    }
+
+    // Moves the elements into memory interleaved page by page over all nodes, for data that all
+    // threads read in random order. The copy touches the new pages under the interleave policy.
+    template <typename T>
+    static void interleave(std::vector<T>& data) {
+#ifdef USE_NUMA
+        if (not enabled() or data.size() * sizeof(T) < InterleaveMinBytes) return;
+        std::vector<T> interleaved;
+        interleaved.reserve(data.size());
+        // mbind() needs whole pages; the partial first page keeps the default policy
+        const uintptr_t page = numa_pagesize();
+        const uintptr_t begin = (reinterpret_cast<uintptr_t>(interleaved.data()) + page - 1) / page * page;
+        const uintptr_t end = reinterpret_cast<uintptr_t>(interleaved.data() + data.size());
+        if (end > begin) numa_interleave_memory(reinterpret_cast<void*>(begin), end - begin, numa_all_nodes_ptr);
+        interleaved.insert(interleaved.end(), data.begin(), data.end());
+        data.swap(interleaved);
+#endif
+    }
+
+private:
+    // Smaller buffers live on the heap among other objects and are not worth a copy
+    static constexpr size_t InterleaveMinBytes = 1 << 22;
+};
+
+#endif //NUMA_HPP
@@ -2,7 +2,15 @@
 #define PARAMETERS_HPP
 
 #include <basics/cxxopts.hpp>
+#include <basics/random.hpp>
+#include <basics/numa.hpp>
+#include <basics/perf_counters.hpp>
+#include <chrono>
 #include <iostream>
+#include <limits>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 class Parameters
 {
@@ -16,11 +24,28 @@ public:
         os<< "\tk: " << p.k() << std::endl;
         os<< "\ts: " << p.s() << std::endl;
         os<< "\treps: " << p.reps() << std::endl;
+        os<< "\tnode-counts: " << p.nodeCounts() << std::endl;
+        os<< "\tedge-counts: " << p.edgeCounts() << std::endl;
+        os<< "\tseed: " << p.seed() << std::endl;
+        os<< "\tthreads: " << p.threads() << std::endl;
+        os<< "\treport: " << p.report() << std::endl;
+        os<< "\tperf: " << p.perf() << std::endl;
+        os<< "\tmem-budget: " << p.memBudget() << std::endl;
+        os<< "\tcalibrate: " << p.calibrate() << std::endl;
+        os<< "\ttime-budget: " << p.timeBudget() << std::endl;
+        os<< "\ttarget-rse: " << p.targetRSE() << std::endl;
+        os<< "\talgo: " << p.algo() << std::endl;
+        os<< "\tconcurrent: " << p.concurrent() << std::endl;
+        os<< "\tfused: " << p.fused() << std::endl;
+        os<< "\tstream: " << p.stream() << std::endl;
+        os<< "\twindow: " << p.window() << std::endl;
+        os<< "\treport-every: " << p.reportEvery() << std::endl;
         return os << "---------------------------------------" << std::endl;
     }
 
     void read_parameters(int argc, char**argv)
     {
+        _startTime = std::chrono::steady_clock::now();
         cxxopts::Options options("[EXECUTABLE]", "");
         try{
 
@@ -29,6 +54,22 @@ public:
             ("k", "Target graph sample size / Number of edges stored.", cxxopts::value<int>()->default_value("20000"))
             ("s", "EISm: Average of s samples which in total use k edges.", cxxopts::value<int>()->default_value("32"))
             ("r,reps", "Repetitions of the algorithm.", cxxopts::value<int>()->default_value("10"))
+            ("node-counts", "exact/EIS/EISm: Write the four-cycle count (EIS: estimate averaged over all reps) of every node to this file. Nodes of bipartite inputs are written as L<id> and R<id>.", cxxopts::value<std::string>()->default_value(""))
+            ("edge-counts", "exact: Write the four-cycle count of every edge to this file. Nodes as for node-counts.", cxxopts::value<std::string>()->default_value(""))
+            ("seed", "Seed for all random generators. Random if not given.", cxxopts::value<uint64_t>())
+            ("t,threads", "Number of threads for parallel code paths. 0 uses all.", cxxopts::value<int>()->default_value("0"))
+            ("report", "Print a machine-readable run report instead of the text output: json or csv.", cxxopts::value<std::string>()->default_value(""))
+            ("perf", "Measure hardware performance counters (cycles, instructions, LLC/branch/dTLB misses) per timer.")
+            ("mem-budget", "EIS/EISm: Choose the largest k (EISm: and s up to -s) fitting into this much memory, e.g. 512M or 4G.", cxxopts::value<std::string>()->default_value(""))
+            ("calibrate", "EIS/EISm: Calibrate the memory model of --mem-budget on a small sample of the input.")
+            ("time-budget", "EIS/EISm/NIS/3ES: Keep repeating until the next repetition would exceed this many seconds since the start.", cxxopts::value<double>()->default_value("0"))
+            ("target-rse", "EIS/EISm/NIS/3ES: Keep repeating until the relative standard error of the mean estimate is at most this.", cxxopts::value<double>()->default_value("0"))
+            ("algo", "eis-run/turnstile: Comma-separated algorithms to run on the input: EIS, EISm, NIS, 3ES, exact.", cxxopts::value<std::string>()->default_value("EIS,EISm,NIS,3ES,exact"))
+            ("concurrent", "eis-run: Run the algorithms concurrently, one thread each.")
+            ("fused", "eis-run: Run the sampling algorithms with one shared scan of the edges per pass; exact runs on its own.")
+            ("stream", "eis-run: Like --fused, but scan a binary input file in blocks on every pass instead of loading the graph.")
+            ("window", "window: Length of the sliding window in the time unit of the input timestamps.", cxxopts::value<long long>()->default_value("0"))
+            ("report-every", "window: Print an estimate after every this many edges.", cxxopts::value<long long>()->default_value("10000"))
             ("h,help", "Print this information.");
 
 
@@ -47,6 +88,48 @@ public:
             _k = parse_result["k"].as<int>();
             _s = parse_result["s"].as<int>();
             _reps = parse_result["reps"].as<int>();
+            _timeBudget = parse_result["time-budget"].as<double>();
+            _targetRSE = parse_result["target-rse"].as<double>();
+            if (_targetRSE > 0 and _timeBudget <= 0 and not parse_result.count("reps")) {
+                // the target may never be reached, e.g. with a standard error that stays unknown
+                throw std::invalid_argument("target-rse needs time-budget or reps as a bound");
+            }
+            if (anytime() and not parse_result.count("reps")) {
+                _reps = std::numeric_limits<int>::max(); // only the budget or the target ends the run
+            }
+            _nodeCounts = parse_result["node-counts"].as<std::string>();
+            _edgeCounts = parse_result["edge-counts"].as<std::string>();
+            _seed = parse_result.count("seed") ? parse_result["seed"].as<uint64_t>() : 0;
+            _threads = parse_result["threads"].as<int>();
+            _report = parse_result["report"].as<std::string>();
+            if (not _report.empty() and _report != "json" and _report != "csv") {
+                throw std::invalid_argument("report must be json or csv");
+            }
+
+            _memBudget = parse_result["mem-budget"].as<std::string>();
+            _calibrate = parse_result.count("calibrate") > 0;
+            _perf = parse_result.count("perf") > 0;
+            _algo = parse_result["algo"].as<std::string>();
+            _concurrent = parse_result.count("concurrent") > 0;
+            _fused = parse_result.count("fused") > 0;
+            _stream = parse_result.count("stream") > 0;
+            _window = parse_result["window"].as<long long>();
+            _reportEvery = parse_result["report-every"].as<long long>();
+            if (_perf) {
+                PerfCounters::enable();
+            }
+            if (parse_result.count("seed")) {
+                Seeds::set(_seed);
+            }
+#ifdef _OPENMP
+            if (_threads > 0) {
+                omp_set_num_threads(_threads);
+            }
+            _threads = omp_get_max_threads();
+            Numa::pinThreads();
+#else
+            _threads = 1;
+#endif
         }
         catch (const std::exception& e) {
             std::cerr << "Error parsing options: " << e.what() << std::endl;
@@ -60,11 +143,53 @@ public:
     int k()     const {return _k;}
     int s()     const {return _s;}
     int reps()     const {return _reps;}
+    std::string nodeCounts()     const {return _nodeCounts;}
+    std::string edgeCounts()     const {return _edgeCounts;}
+    uint64_t seed()     const {return _seed;}
+    int threads()     const {return _threads;}
+    std::string report()     const {return _report;}
+    bool perf()     const {return _perf;}
+    std::string memBudget()     const {return _memBudget;}
+    bool calibrate()     const {return _calibrate;}
+
+    double timeBudget()     const {return _timeBudget;}
+    double targetRSE()     const {return _targetRSE;}
+    bool anytime()     const {return _timeBudget > 0 or _targetRSE > 0;}
+    std::chrono::steady_clock::time_point startTime()     const {return _startTime;}
+    std::string algo()     const {return _algo;}
+    bool concurrent()     const {return _concurrent;}
+    bool fused()     const {return _fused;}
+    bool stream()     const {return _stream;}
+    long long window()     const {return _window;}
+    long long reportEvery()     const {return _reportEvery;}
+
+    // Sample sizes chosen at runtime, e.g. by --mem-budget
+    void setSampleSize(int k, int s) {
+        _k = k;
+        _s = s;
+    }
 private:
     std::string     _input;
     int     _k;
     int     _s;
     int     _reps;
+    std::string     _nodeCounts;
+    std::string     _edgeCounts;
+    uint64_t     _seed;
+    int     _threads;
+    std::string     _report;
+    bool     _perf;
+    std::string     _memBudget;
+    bool     _calibrate;
+    double     _timeBudget;
+    double     _targetRSE;
+    std::string     _algo;
+    bool     _concurrent;
+    bool     _fused;
+    bool     _stream;
+    long long     _window;
+    long long     _reportEvery;
+    std::chrono::steady_clock::time_point     _startTime;
 };
 
 inline Parameters Parms;
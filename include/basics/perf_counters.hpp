@@ -0,0 +1,121 @@
+#ifndef PERF_COUNTERS_HPP
+#define PERF_COUNTERS_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Hardware performance counters via perf_event_open. The counters of a thread include the threads
+// it starts afterwards (inherit), so enable() opens those of the calling thread before the OpenMP
+// pool exists: regions timed on the main thread then also count the work of the OpenMP threads
+// during the region. ScopedTimer reads them at the begin and end of every region while enabled.
+// If the kernel does not permit an event (perf_event_paranoid, containers, VMs), it is reported as
+// unavailable; if no event can be opened at all, counting is switched off with a single warning.
+class PerfCounters {
+public:
+    enum Event { Cycles, Instructions, LLCMisses, BranchMisses, DTLBMisses, NumEvents };
+    using Values = std::array<int64_t, NumEvents>;
+
+    static const char* name(int event) {
+        static constexpr const char* names[NumEvents] = {"cycles", "instructions", "LLC-misses", "branch-misses", "dTLB-misses"};
+        return names[event];
+    }
+
+    static void enable() {
+        _enabled = true;
+#ifdef __linux__
+        threadCounters();
+#endif
+    }
+    static bool enabled() { return _enabled.load(std::memory_order_relaxed); }
+    // Events that could be opened by at least one thread
+    static bool available(int event) { return _available[event].load(std::memory_order_relaxed); }
+
+    // Current counter values of the calling thread and the threads it started, scaled for
+    // multiplexing. Unavailable events read 0.
+    static Values read() {
+        Values values{};
+#ifdef __linux__
+        const ThreadCounters& counters = threadCounters();
+        for (int e = 0; e < NumEvents; ++e) {
+            if (counters.fds[e] < 0) continue;
+            // TOTAL_TIME_ENABLED | TOTAL_TIME_RUNNING: value, enabled, running. Inherited counters
+            // cannot be read as a group on older kernels, so every event is read on its own.
+            uint64_t buffer[3];
+            if (::read(counters.fds[e], buffer, sizeof(buffer)) <= 0) continue;
+            double scale = buffer[2] > 0 ? 1.0 * buffer[1] / buffer[2] : 1.0;
+            values[e] = static_cast<int64_t>(buffer[0] * scale);
+        }
+#endif
+        return values;
+    }
+
+private:
+#ifdef __linux__
+    struct ThreadCounters {
+        std::array<int, NumEvents> fds;
+
+        ThreadCounters() {
+            fds.fill(-1);
+            static constexpr std::pair<uint32_t, uint64_t> configs[NumEvents] = {
+                {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+                {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+                {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+                {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+                {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+            };
+            bool opened = false;
+            for (int e = 0; e < NumEvents; ++e) {
+                struct perf_event_attr attr;
+                std::memset(&attr, 0, sizeof(attr));
+                attr.size = sizeof(attr);
+                attr.type = configs[e].first;
+                attr.config = configs[e].second;
+                attr.exclude_kernel = 1; // permitted up to perf_event_paranoid = 2
+                attr.exclude_hv = 1;
+                attr.inherit = 1;
+                attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+                int fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+                if (fd < 0) continue;
+                fds[e] = fd;
+                opened = true;
+                _available[e] = true;
+            }
+            if (not opened) {
+                _enabled = false;
+                bool expected = false;
+                if (_warned.compare_exchange_strong(expected, true)) {
+                    std::cerr << "Warning: perf_event_open is not permitted, continuing without performance counters." << std::endl;
+                }
+            }
+        }
+
+        ~ThreadCounters() {
+            for (int fd : fds) {
+                if (fd >= 0) close(fd);
+            }
+        }
+    };
+
+    static ThreadCounters& threadCounters() {
+        thread_local ThreadCounters counters;
+        return counters;
+    }
+#endif
+
+    static inline std::atomic<bool> _enabled = false;
+    static inline std::atomic<bool> _warned = false;
+    static inline std::array<std::atomic<bool>, NumEvents> _available{};
+};
+
+#endif //PERF_COUNTERS_HPP
@@ -0,0 +1,53 @@
+#ifndef RANDOM_HPP
+#define RANDOM_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <random>
+
+// Seeds for all random generators. Unless a seed is set, every generator is seeded from
+// std::random_device. With a seed, generators created in the same order receive the same seeds.
+// Threads running independent algorithms can draw from their own sequence (useStream), which keeps
+// their seeds the same whether the algorithms run concurrently or one after another.
+class Seeds {
+public:
+    static void set(uint64_t seed) {
+        _seed = seed;
+        _counter = 0;
+        _fixed = true;
+    }
+
+    static bool fixed() { return _fixed; }
+    static uint64_t seed() { return _seed; }
+
+    // Sequence of the calling thread; stream 0 is the one shared by all threads
+    static void useStream(uint64_t stream) {
+        _stream = stream;
+        _streamCounter = 0;
+    }
+
+    static uint64_t next() {
+        if (not _fixed) {
+            std::random_device rd;
+            return (static_cast<uint64_t>(rd()) << 32) ^ rd();
+        }
+        if (_stream == 0) return splitmix64(_seed + (++_counter) * 0x9e3779b97f4a7c15ULL);
+        const uint64_t streamSeed = splitmix64(_seed ^ (_stream * 0xd1b54a32d192ed03ULL));
+        return splitmix64(streamSeed + (++_streamCounter) * 0x9e3779b97f4a7c15ULL);
+    }
+
+private:
+    static uint64_t splitmix64(uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    static inline uint64_t _seed = 0;
+    static inline std::atomic<uint64_t> _counter = 0;
+    static inline bool _fixed = false;
+    static inline thread_local uint64_t _stream = 0;
+    static inline thread_local uint64_t _streamCounter = 0;
+};
+
+#endif //RANDOM_HPP
@@ -0,0 +1,384 @@
+#ifndef REPORT_HPP
+#define REPORT_HPP
+
+#include <atomic>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include "basics/memory.hpp"
+#include "basics/parms.hpp"
+#include "basics/random.hpp"
+#include "basics/sample_stats.hpp"
+#include "basics/statistics.hpp"
+#include "basics/timer.hpp"
+#include "basics/wide_count.hpp"
+
+// Collects the results of a run. Without --report the estimates are printed as they come in and
+// the run ends with the timer table; with --report=json|csv only the machine-readable report is printed.
+// A process may run several algorithms on the same graph (eis-run); results are then kept per
+// algorithm and go to the algorithm the calling thread selected last with setRun().
+class RunReport {
+public:
+    using SampleStats = ::SampleStats;
+
+    // Registers the algorithm if needed and directs the results of this thread to it
+    static void setRun(const std::string& algorithm, long long n, long long m) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _n = n;
+        _m = m;
+        for (size_t i = 0; i < _runs.size(); ++i) {
+            if (_runs[i].algorithm == algorithm) {
+                _current = i;
+                return;
+            }
+        }
+        _runs.push_back({algorithm, {}, {}});
+        _current = _runs.size() - 1;
+    }
+
+    static void addEstimate(const Estimate& estimate) {
+        addResult(EstimatorResult(estimate));
+    }
+
+    static void addExact(c4count count) {
+        addResult(EstimatorResult::exactCount(count));
+    }
+
+    // Records the estimate of a repetition; with more than one sample, also its error bars
+    static void addResult(const EstimatorResult& result) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        Run& run = current();
+        run.results.push_back(result);
+        if (Parms.report().empty()) {
+            if (_runs.size() > 1) std::cout << run.algorithm << "\t";
+            std::cout << result;
+            if (result.samples.size() > 1) {
+                auto [low, high] = result.confidenceInterval();
+                std::cout << "\t95% CI [" << Estimate(low) << ", " << Estimate(high) << "]";
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    static void addSample(const SampleStats& stats) {
+        if (not _keepSamples) return;
+        std::lock_guard<std::mutex> lock(_mutex);
+        current().samples.push_back(stats);
+    }
+
+    // Off by default: long-running processes (eisd, services using the library) would otherwise
+    // keep the sizes of every sample they ever drew. The executables printing reports turn it on.
+    static void keepSamples(bool keep) {
+        _keepSamples = keep;
+    }
+
+    static long long peakRSS() {
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss * 1024LL; // kilobytes on Linux
+    }
+
+    // Edges of the input processed per second by the estimator, summed over all repetitions
+    static double edgesPerSecond(const std::string& algorithm) {
+        for (const auto& [name, data] : ScopedTimer::collect()) {
+            if (name == algorithm and data.ns > 0) return 1e9 * _m * data.count / data.ns;
+        }
+        return 0;
+    }
+
+    static void print() {
+        if (Parms.report().empty()) {
+            print_summary();
+            ScopedTimer::print_timers();
+            print_memory();
+        } else if (Parms.report() == "json") {
+            writeJSON(std::cout);
+        } else if (Parms.report() == "csv") {
+            writeCSV(std::cout);
+        } else {
+            throw std::runtime_error("Unknown report format: " + Parms.report());
+        }
+    }
+
+    static void print_summary() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (const auto& run : _runs) {
+            RunningStats stats = summary(run);
+            if (stats.count() < 2) continue;
+            auto [low, high] = stats.confidenceInterval();
+            if (_runs.size() > 1) std::cout << run.algorithm << ": ";
+            std::cout << "Mean " << Estimate(stats.mean()) << ", 95% CI [" << Estimate(low) << ", " << Estimate(high)
+                      << "], RSE " << stats.relativeStandardError() << " over " << stats.count() << " repetitions" << std::endl;
+        }
+    }
+
+    // Peak memory per subsystem and of the whole process
+    static void print_memory() {
+        std::cout << std::string(120, '-') << std::endl;
+        std::cout << std::setw(40) << std::left << "Memory" << std::right << std::setw(14) << "Peak" << std::endl;
+        for (const auto& [subsystem, bytes] : MemoryTracker::peaks()) {
+            std::cout << std::setw(40) << std::left << subsystem << std::right << std::setw(14) << MemoryTracker::format(bytes) << std::endl;
+        }
+        std::cout << std::setw(40) << std::left << "peak RSS" << std::right << std::setw(14) << MemoryTracker::format(peakRSS()) << std::endl;
+    }
+
+    // With a single algorithm its results are top-level fields, otherwise they are grouped under "runs"
+    static void writeJSON(std::ostream& os) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        const bool single = _runs.size() == 1;
+        os << "{\n";
+        os << "  \"algorithm\": \"" << escape(algorithms()) << "\",\n";
+        os << "  \"parameters\": {\"input\": \"" << escape(Parms.input()) << "\", \"k\": " << Parms.k() << ", \"s\": " << Parms.s()
+           << ", \"reps\": " << (unboundedReps() ? "null" : std::to_string(Parms.reps())) << ", \"seed\": " << (Seeds::fixed() ? std::to_string(Seeds::seed()) : "null")
+           << ", \"threads\": " << Parms.threads() << ", \"time_budget\": " << Parms.timeBudget() << ", \"target_rse\": " << Parms.targetRSE() << "},\n";
+        os << "  \"graph\": {\"n\": " << _n << ", \"m\": " << _m << "},\n";
+        if (single) {
+            writeRunJSON(os, _runs[0], "  ");
+        } else {
+            os << "  \"runs\": {";
+            for (size_t i = 0; i < _runs.size(); ++i) {
+                os << (i ? "," : "") << "\n    \"" << escape(_runs[i].algorithm) << "\": {\n";
+                writeRunJSON(os, _runs[i], "      ");
+                os << "      \"edges_per_second\": " << edgesPerSecond(_runs[i].algorithm) << "\n    }";
+            }
+            os << "\n  },\n";
+        }
+        os << "  \"timers\": {";
+        bool first = true;
+        for (const auto& [name, data] : ScopedTimer::collect()) {
+            os << (first ? "" : ",") << "\n    \"" << escape(name) << "\": {\"count\": " << data.count << ", \"total_ns\": " << data.ns
+               << ", \"min_ns\": " << data.min_ns << ", \"median_ns\": " << data.percentile(0.5) << ", \"p99_ns\": " << data.percentile(0.99)
+               << ", \"max_ns\": " << data.max_ns;
+            for (int e = 0; e < PerfCounters::NumEvents; ++e) {
+                if (PerfCounters::enabled() and PerfCounters::available(e)) os << ", \"" << PerfCounters::name(e) << "\": " << data.perf[e];
+            }
+            os << "}";
+            first = false;
+        }
+        os << "\n  },\n";
+        os << "  \"memory_bytes\": {";
+        first = true;
+        for (const auto& [subsystem, bytes] : MemoryTracker::peaks()) {
+            os << (first ? "" : ", ") << "\"" << escape(subsystem) << "\": " << bytes;
+            first = false;
+        }
+        os << "},\n";
+        os << "  \"peak_rss_bytes\": " << peakRSS();
+        if (single) {
+            os << ",\n  \"edges_per_second\": " << edgesPerSecond(_runs[0].algorithm);
+        }
+        os << "\n}" << std::endl;
+    }
+
+    // One value per row: section,name,field,value. With several algorithms, the sections of
+    // their results are prefixed by the algorithm, e.g. NIS.estimate
+    static void writeCSV(std::ostream& os) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        os << "section,name,field,value\n";
+        for (const auto& run : _runs) {
+            os << "run,algorithm,,"  << run.algorithm << "\n";
+        }
+        os << "parameter,input,," << Parms.input() << "\n";
+        os << "parameter,k,," << Parms.k() << "\n";
+        os << "parameter,s,," << Parms.s() << "\n";
+        os << "parameter,reps,," << (unboundedReps() ? "" : std::to_string(Parms.reps())) << "\n";
+        os << "parameter,seed,," << (Seeds::fixed() ? std::to_string(Seeds::seed()) : "") << "\n";
+        os << "parameter,threads,," << Parms.threads() << "\n";
+        os << "parameter,time_budget,," << Parms.timeBudget() << "\n";
+        os << "parameter,target_rse,," << Parms.targetRSE() << "\n";
+        os << "graph,n,," << _n << "\n";
+        os << "graph,m,," << _m << "\n";
+        for (const auto& run : _runs) {
+            writeRunCSV(os, run, sectionPrefix(run));
+        }
+        for (const auto& [name, data] : ScopedTimer::collect()) {
+            os << "timer," << name << ",count," << data.count << "\n";
+            os << "timer," << name << ",total_ns," << data.ns << "\n";
+            os << "timer," << name << ",min_ns," << data.min_ns << "\n";
+            os << "timer," << name << ",median_ns," << data.percentile(0.5) << "\n";
+            os << "timer," << name << ",p99_ns," << data.percentile(0.99) << "\n";
+            os << "timer," << name << ",max_ns," << data.max_ns << "\n";
+            for (int e = 0; e < PerfCounters::NumEvents; ++e) {
+                if (PerfCounters::enabled() and PerfCounters::available(e)) os << "timer," << name << "," << PerfCounters::name(e) << "," << data.perf[e] << "\n";
+            }
+        }
+        for (const auto& [subsystem, bytes] : MemoryTracker::peaks()) {
+            os << "memory," << subsystem << ",peak_bytes," << bytes << "\n";
+        }
+        os << "memory,peak_rss_bytes,," << peakRSS() << "\n";
+        for (const auto& run : _runs) {
+            os << sectionPrefix(run) << "throughput,edges_per_second,," << edgesPerSecond(run.algorithm) << "\n";
+        }
+        os << std::flush;
+    }
+
+private:
+    struct Run {
+        std::string algorithm;
+        std::vector<EstimatorResult> results;
+        std::vector<SampleStats> samples;
+    };
+
+    // The run of the calling thread, an unnamed one if it never selected one. Requires the lock.
+    static Run& current() {
+        if (_current < 0 or _current >= static_cast<int>(_runs.size())) {
+            _runs.push_back({"", {}, {}});
+            _current = _runs.size() - 1;
+        }
+        return _runs[_current];
+    }
+
+    // Section prefix of the CSV rows of a run
+    static std::string sectionPrefix(const Run& run) {
+        return _runs.size() == 1 ? "" : run.algorithm + ".";
+    }
+
+    static std::string algorithms() {
+        std::string names;
+        for (const auto& run : _runs) {
+            names += (names.empty() ? "" : ",") + run.algorithm;
+        }
+        return names;
+    }
+
+    // Statistics of the estimates over all repetitions
+    static RunningStats summary(const Run& run) {
+        RunningStats stats;
+        for (const auto& result : run.results) {
+            stats.add(result.estimate.value());
+        }
+        return stats;
+    }
+
+    static void writeRunJSON(std::ostream& os, const Run& run, const std::string& indent) {
+        RunningStats stats = summary(run);
+        os << indent << "\"estimates\": [";
+        for (size_t i = 0; i < run.results.size(); ++i) {
+            os << (i ? ", " : "") << run.results[i];
+        }
+        os << "],\n";
+        if (stats.count() >= 2) {
+            auto [low, high] = stats.confidenceInterval();
+            os << indent << "\"summary\": {\"mean\": " << Estimate(stats.mean()) << ", \"standard_error\": ";
+            writeFinite(os, Estimate(stats.standardError()), "null");
+            os << ", \"rse\": ";
+            writeFinite(os, stats.relativeStandardError(), "null");
+            os << ", \"ci95\": [";
+            writeFinite(os, Estimate(low), "null");
+            os << ", ";
+            writeFinite(os, Estimate(high), "null");
+            os << "]},\n";
+        }
+        os << indent << "\"repetitions\": [";
+        for (size_t i = 0; i < run.results.size(); ++i) {
+            const auto& result = run.results[i];
+            auto [low, high] = result.confidenceInterval();
+            os << (i ? "," : "") << "\n" << indent << "  {\"estimate\": " << result;
+            if (result.samples.size() > 1) {
+                os << ", \"standard_error\": ";
+                writeFinite(os, Estimate(result.standardError()), "null");
+                os << ", \"ci95\": [";
+                writeFinite(os, Estimate(low), "null");
+                os << ", ";
+                writeFinite(os, Estimate(high), "null");
+                os << "], \"median_of_means\": " << result.medianOfMeans() << ", \"sample_estimates\": [";
+                for (size_t j = 0; j < result.samples.size(); ++j) {
+                    os << (j ? ", " : "") << Estimate(result.samples[j]);
+                }
+                os << "]";
+            }
+            os << "}";
+        }
+        os << (run.results.empty() ? "" : "\n" + indent) << "],\n";
+        os << indent << "\"samples\": [";
+        for (size_t i = 0; i < run.samples.size(); ++i) {
+            const auto& s = run.samples[i];
+            os << (i ? "," : "") << "\n" << indent << "  {\"reservoir\": " << s.reservoir << ", \"inducedEdges\": " << s.inducedEdges
+               << ", \"removedSampledEdges\": " << s.removedSampledEdges << ", \"removedNodes\": " << s.removedNodes << "}";
+        }
+        os << (run.samples.empty() ? "" : "\n" + indent) << "],\n";
+    }
+
+    static void writeRunCSV(std::ostream& os, const Run& run, const std::string& prefix) {
+        RunningStats stats = summary(run);
+        for (size_t i = 0; i < run.results.size(); ++i) {
+            os << prefix << "estimate," << i << ",," << run.results[i] << "\n";
+        }
+        if (stats.count() >= 2) {
+            auto [low, high] = stats.confidenceInterval();
+            os << prefix << "summary,mean,," << Estimate(stats.mean()) << "\n";
+            os << prefix << "summary,standard_error,,";
+            writeFinite(os, Estimate(stats.standardError()), "");
+            os << "\n" << prefix << "summary,rse,,";
+            writeFinite(os, stats.relativeStandardError(), "");
+            os << "\n" << prefix << "summary,ci95,low,";
+            writeFinite(os, Estimate(low), "");
+            os << "\n" << prefix << "summary,ci95,high,";
+            writeFinite(os, Estimate(high), "");
+            os << "\n";
+        }
+        for (size_t i = 0; i < run.results.size(); ++i) {
+            const auto& result = run.results[i];
+            if (result.samples.size() < 2) continue;
+            auto [low, high] = result.confidenceInterval();
+            os << prefix << "repetition," << i << ",standard_error,";
+            writeFinite(os, Estimate(result.standardError()), "");
+            os << "\n" << prefix << "repetition," << i << ",ci95_low,";
+            writeFinite(os, Estimate(low), "");
+            os << "\n" << prefix << "repetition," << i << ",ci95_high,";
+            writeFinite(os, Estimate(high), "");
+            os << "\n";
+            os << prefix << "repetition," << i << ",median_of_means," << result.medianOfMeans() << "\n";
+            for (size_t j = 0; j < result.samples.size(); ++j) {
+                os << prefix << "repetition," << i << ",sample_estimate_" << j << "," << Estimate(result.samples[j]) << "\n";
+            }
+        }
+        for (size_t i = 0; i < run.samples.size(); ++i) {
+            const auto& s = run.samples[i];
+            os << prefix << "sample," << i << ",reservoir," << s.reservoir << "\n";
+            os << prefix << "sample," << i << ",inducedEdges," << s.inducedEdges << "\n";
+            os << prefix << "sample," << i << ",removedSampledEdges," << s.removedSampledEdges << "\n";
+            os << prefix << "sample," << i << ",removedNodes," << s.removedNodes << "\n";
+        }
+    }
+
+    // JSON has no inf or nan (e.g. the RSE of a zero mean); they are written as null, or as an
+    // empty CSV field
+    static void writeFinite(std::ostream& os, long double value, const char* missing) {
+        if (std::isfinite(value)) os << value;
+        else os << missing;
+    }
+
+    static void writeFinite(std::ostream& os, const Estimate& value, const char* missing) {
+        if (std::isfinite(value.value())) os << value;
+        else os << missing;
+    }
+
+    // Anytime runs without -r only end on their budget or target
+    static bool unboundedReps() {
+        return Parms.reps() == std::numeric_limits<int>::max();
+    }
+
+    static std::string escape(const std::string& s) {
+        std::string out;
+        for (char c : s) {
+            if (c == '"' or c == '\\') out.push_back('\\');
+            out.push_back(c);
+        }
+        return out;
+    }
+
+    static inline std::mutex _mutex;
+    static inline std::atomic<bool> _keepSamples = false;
+    static inline long long _n = 0;
+    static inline long long _m = 0;
+    static inline std::vector<Run> _runs;
+    static inline thread_local int _current = -1;
+};
+
+#endif //REPORT_HPP
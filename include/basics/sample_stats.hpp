@@ -0,0 +1,12 @@
+#ifndef SAMPLE_STATS_HPP
+#define SAMPLE_STATS_HPP
+
+// Sizes a sample ended up with, recorded by the estimators (see RunReport::addSample)
+struct SampleStats {
+    long long reservoir = 0;           // sampled edges (final reservoir size)
+    long long inducedEdges = 0;        // edges collected in the second pass
+    long long removedSampledEdges = 0; // sampled edges dropped to stay within space
+    long long removedNodes = 0;
+};
+
+#endif //SAMPLE_STATS_HPP
@@ -0,0 +1,75 @@
+#ifndef SERIALIZE_HPP
+#define SERIALIZE_HPP
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Raw values in host byte order, like the binary graph files. Vectors are preceded by their size.
+class Binary {
+public:
+    template <typename T> requires std::is_trivially_copyable_v<T>
+    static void write(std::ostream& out, const T& value) {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T> requires std::is_trivially_copyable_v<T>
+    static void write(std::ostream& out, const std::vector<T>& values) {
+        write<uint64_t>(out, values.size());
+        out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+    }
+
+    // Edges as two 32 bit node ids each (std::pair is not trivially copyable)
+    static void write(std::ostream& out, const std::vector<std::pair<int, int>>& edges) {
+        std::vector<uint32_t> ids;
+        ids.reserve(2 * edges.size());
+        for (const auto& [u, v] : edges) {
+            ids.push_back(u);
+            ids.push_back(v);
+        }
+        write<uint64_t>(out, edges.size());
+        out.write(reinterpret_cast<const char*>(ids.data()), ids.size() * sizeof(uint32_t));
+    }
+
+    template <typename T> requires std::is_trivially_copyable_v<T>
+    static T read(std::istream& in) {
+        T value;
+        in.read(reinterpret_cast<char*>(&value), sizeof(T));
+        check(in);
+        return value;
+    }
+
+    template <typename T> requires std::is_trivially_copyable_v<T>
+    static std::vector<T> readVector(std::istream& in) {
+        std::vector<T> values(read<uint64_t>(in));
+        in.read(reinterpret_cast<char*>(values.data()), values.size() * sizeof(T));
+        check(in);
+        return values;
+    }
+
+    static std::vector<std::pair<int, int>> readEdges(std::istream& in) {
+        const auto ids = [&] {
+            std::vector<uint32_t> ids(2 * read<uint64_t>(in));
+            in.read(reinterpret_cast<char*>(ids.data()), ids.size() * sizeof(uint32_t));
+            check(in);
+            return ids;
+        }();
+        std::vector<std::pair<int, int>> edges;
+        edges.reserve(ids.size() / 2);
+        for (size_t i = 0; i < ids.size(); i += 2) {
+            edges.emplace_back(ids[i], ids[i + 1]);
+        }
+        return edges;
+    }
+
+private:
+    static void check(const std::istream& in) {
+        if (!in) throw std::runtime_error("Unexpected end of binary data.");
+    }
+};
+
+#endif //SERIALIZE_HPP
@@ -0,0 +1,123 @@
+#ifndef STATISTICS_HPP
+#define STATISTICS_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <optional>
+#include <random>
+#include <utility>
+#include <vector>
+#include "basics/wide_count.hpp"
+
+// Mean and variance of a stream of values (Welford), in long double like the estimates
+class RunningStats {
+public:
+    void add(long double x) {
+        _count++;
+        const long double delta = x - _mean;
+        _mean += delta / _count;
+        _m2 += delta * (x - _mean);
+    }
+
+    long long count() const { return _count; }
+    long double mean() const { return _mean; }
+
+    // Sample variance, 0 for fewer than two values
+    long double variance() const { return _count > 1 ? _m2 / (_count - 1) : 0; }
+
+    long double standardError() const { return std::sqrt(variance() / _count); }
+
+    // Standard error relative to the mean, infinite as long as it cannot be estimated
+    long double relativeStandardError() const {
+        if (_count < 2 or _mean == 0) return INFINITY;
+        return standardError() / std::fabs(_mean);
+    }
+
+    // Two-sided 95% confidence interval of the mean (Student t). The values are counts, so the
+    // lower bound is clamped at 0.
+    std::pair<long double, long double> confidenceInterval() const {
+        if (_count < 2) return {0, INFINITY};
+        const long double halfWidth = tQuantile975(_count - 1) * standardError();
+        return {std::max<long double>(0, _mean - halfWidth), _mean + halfWidth};
+    }
+
+    // 97.5% quantile of the t distribution with the given degrees of freedom
+    static double tQuantile975(long long df) {
+        static const double table[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                       2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                       2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+        if (df <= 30) return table[df - 1];
+        return 1.960 + 2.4 / df; // within 0.002 of the exact quantile
+    }
+
+private:
+    long long _count = 0;
+    long double _mean = 0;
+    long double _m2 = 0;
+};
+
+// Result of one estimator run: the point estimate and the estimates of the independent samples
+// it averages (EISm: one per sample, otherwise just one). The error bars are computed from these
+// values alone, without further passes over the graph. Exact counts keep their integer value,
+// which long double only holds up to 2^64.
+struct EstimatorResult {
+    Estimate estimate;
+    std::vector<long double> samples;
+    std::optional<c4count> exact;
+
+    EstimatorResult(Estimate estimate = 0) : estimate(estimate), samples{estimate.value()} {}
+    EstimatorResult(Estimate estimate, std::vector<long double> samples) : estimate(estimate), samples(std::move(samples)) {}
+
+    static EstimatorResult exactCount(c4count count) {
+        EstimatorResult result(static_cast<long double>(count));
+        result.exact = count;
+        return result;
+    }
+
+    // The exact count if there is one, the estimate otherwise
+    friend std::ostream& operator<<(std::ostream& os, const EstimatorResult& result) {
+        if (result.exact) return os << *result.exact;
+        return os << result.estimate;
+    }
+
+    RunningStats stats() const {
+        RunningStats stats;
+        for (long double x : samples) stats.add(x);
+        return stats;
+    }
+
+    // Variance of a single sample estimate and the standard error of their mean
+    long double variance() const { return stats().variance(); }
+    long double standardError() const { return samples.size() > 1 ? stats().standardError() : INFINITY; }
+
+    // Median of the means of about sqrt(s) groups of consecutive samples, robust against single
+    // samples that hit a dense subgraph
+    Estimate medianOfMeans() const {
+        const size_t groups = std::max<size_t>(1, std::sqrt(samples.size()));
+        std::vector<long double> means(groups, 0);
+        for (size_t g = 0; g < groups; ++g) {
+            const size_t begin = g * samples.size() / groups, end = (g + 1) * samples.size() / groups;
+            for (size_t i = begin; i < end; ++i) means[g] += samples[i] / (end - begin);
+        }
+        std::nth_element(means.begin(), means.begin() + groups / 2, means.end());
+        return means[groups / 2];
+    }
+
+    // Percentile bootstrap 95% confidence interval of the mean, unbounded above for a single sample.
+    // The resampling generator has a fixed seed, so that reports are reproducible.
+    std::pair<long double, long double> confidenceInterval(int resamples = 1000) const {
+        if (samples.size() < 2) return {0, INFINITY};
+        std::mt19937_64 gen(samples.size());
+        std::uniform_int_distribution<size_t> pick(0, samples.size() - 1);
+        std::vector<long double> means(resamples);
+        for (auto& mean : means) {
+            long double sum = 0;
+            for (size_t i = 0; i < samples.size(); ++i) sum += samples[pick(gen)];
+            mean = sum / samples.size();
+        }
+        std::sort(means.begin(), means.end());
+        return {means[resamples * 25 / 1000], means[resamples * 975 / 1000 - 1]};
+    }
+};
+
+#endif //STATISTICS_HPP
@@ -1,45 +1,260 @@
 #ifndef TIMER_HPP
 #define TIMER_HPP
 
-#include <fstream>
-#include <iostream>
-#include <map>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
 #include <chrono>
+#include <cstdint>
+#include <deque>
+#include <iomanip>
 #include <iostream>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "basics/perf_counters.hpp"
 
+// Timers are identified by interned ids. Every thread accumulates into its own slots without
+// synchronization; slots of running threads are read and those of finished threads merged when printing.
+// With PerfCounters enabled, every region additionally accumulates the hardware counters of its thread
+// and the threads it started, i.e. regions of the main thread include their OpenMP threads.
+// Hot code should intern once:
+//     static const auto timerId = ScopedTimer::intern("name");
+//     ScopedTimer t(timerId);
 class ScopedTimer{
 public:
-    ScopedTimer(std::string name) : _name(name),_t_begin(std::chrono::steady_clock::now()){};
+    using TimerId = uint32_t;
+
+    // Log-linear histogram: exact below 16 ns, then 8 buckets per power of two (<= 12.5% error)
+    static constexpr int HistogramBuckets = 16 + 60 * 8;
+
+    struct TimerData{
+        int64_t ns = 0;
+        int64_t count = 0;
+        int64_t min_ns = std::numeric_limits<int64_t>::max();
+        int64_t max_ns = 0;
+        std::array<int64_t, HistogramBuckets> histogram{};
+        PerfCounters::Values perf{};
+
+        void merge(const TimerData& other) {
+            ns += other.ns;
+            count += other.count;
+            min_ns = std::min(min_ns, other.min_ns);
+            max_ns = std::max(max_ns, other.max_ns);
+            for (int i = 0; i < HistogramBuckets; ++i) histogram[i] += other.histogram[i];
+            for (int e = 0; e < PerfCounters::NumEvents; ++e) perf[e] += other.perf[e];
+        }
+
+        // Approximate q-quantile, q in [0,1]
+        int64_t percentile(double q) const {
+            if (count == 0) return 0;
+            int64_t rank = std::max<int64_t>(1, static_cast<int64_t>(q * count + 0.5));
+            int64_t seen = 0;
+            for (int i = 0; i < HistogramBuckets; ++i) {
+                seen += histogram[i];
+                if (seen >= rank) return std::clamp(bucketMid(i), min_ns, max_ns);
+            }
+            return max_ns;
+        }
+    };
+
+    explicit ScopedTimer(TimerId id) : _id(id), _perf(PerfCounters::enabled()) {
+        if (_perf) _perf_begin = PerfCounters::read();
+        _t_begin = std::chrono::steady_clock::now();
+    }
+    ScopedTimer(const std::string& name) : ScopedTimer(intern(name)) {}
     ~ScopedTimer() {
         std::chrono::steady_clock::time_point t_end = std::chrono::steady_clock::now();
-        int64_t elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(t_end - _t_begin).count();
-        auto& data = _timers[_name];
-        data.ms += elapsed;
-        data.count++;
-        if (data.max_ms < elapsed)
-            data.max_ms = elapsed;
+        int64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(t_end - _t_begin).count();
+        TimerSlot& slot = threadTimers().slot(_id);
+        slot.record(elapsed);
+        if (_perf) {
+            PerfCounters::Values perf_end = PerfCounters::read();
+            for (int e = 0; e < PerfCounters::NumEvents; ++e) slot.add(slot.perf[e], perf_end[e] - _perf_begin[e]);
+        }
     }
 
-    struct TimerData{
-        int64_t ms = 0;
-        int count = 0;
-        int64_t max_ms = 0;
-    };
+    static TimerId intern(const std::string& name) {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        auto it = r.ids.find(name);
+        if (it != r.ids.end()) return it->second;
+        TimerId id = r.names.size();
+        r.names.push_back(name);
+        r.ids.emplace(name, id);
+        return id;
+    }
+
+    // Aggregate over all threads, sorted by name
+    static std::vector<std::pair<std::string, TimerData>> collect() {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        std::vector<TimerData> data = r.finished;
+        data.resize(r.names.size());
+        for (const ThreadTimers* t : r.live) {
+            for (size_t id = 0; id < t->slots.size(); ++id) {
+                data[id].merge(t->slots[id].load());
+            }
+        }
+        std::vector<std::pair<std::string, TimerData>> result;
+        for (size_t id = 0; id < data.size(); ++id) {
+            if (data[id].count > 0) result.emplace_back(r.names[id], data[id]);
+        }
+        std::sort(result.begin(), result.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        return result;
+    }
 
     static void print_timers() {
-        std::cout << std::string(80, '-') << std::endl;
-        std::cout << std::setw(40) << std::left << "Timer" << std::right << std::setw(9) << "Count" << "    " << std::setw(13) << "Total-Time" << "     " << std::setw(9) << "Max-Time" << std::endl;
-        for(const auto& kvp : _timers) {
-            std::cout << std::setw(40) << std::left << kvp.first << std::right << std::setw(9) << kvp.second.count << "    " << std::setw(13) << (std::to_string(kvp.second.ms) + " ms") << "     " << std::setw(9) << (std::to_string(kvp.second.max_ms) + " ms") << std::endl;
+        std::cout << std::string(120, '-') << std::endl;
+        std::cout << std::setw(40) << std::left << "Timer" << std::right << std::setw(9) << "Count"
+                  << std::setw(14) << "Total-Time" << std::setw(12) << "Min-Time" << std::setw(12) << "Median"
+                  << std::setw(12) << "P99" << std::setw(12) << "Max-Time" << std::endl;
+        for (const auto& [name, data] : collect()) {
+            std::cout << std::setw(40) << std::left << name << std::right << std::setw(9) << data.count
+                      << std::setw(14) << format(data.ns) << std::setw(12) << format(data.min_ns)
+                      << std::setw(12) << format(data.percentile(0.5)) << std::setw(12) << format(data.percentile(0.99))
+                      << std::setw(12) << format(data.max_ns) << std::endl;
+        }
+        if (PerfCounters::enabled()) {
+            print_perf_counters();
         }
     }
 
+    static void print_perf_counters() {
+        std::cout << std::string(120, '-') << std::endl;
+        std::cout << std::setw(40) << std::left << "Timer" << std::right;
+        for (int e = 0; e < PerfCounters::NumEvents; ++e) std::cout << std::setw(14) << PerfCounters::name(e);
+        std::cout << std::setw(8) << "IPC" << std::endl;
+        for (const auto& [name, data] : collect()) {
+            std::cout << std::setw(40) << std::left << name << std::right;
+            for (int e = 0; e < PerfCounters::NumEvents; ++e) {
+                std::cout << std::setw(14) << (PerfCounters::available(e) ? std::to_string(data.perf[e]) : "n/a");
+            }
+            std::ostringstream ipc;
+            if (PerfCounters::available(PerfCounters::Cycles) and PerfCounters::available(PerfCounters::Instructions) and data.perf[PerfCounters::Cycles] > 0) {
+                ipc << std::fixed << std::setprecision(2) << 1.0 * data.perf[PerfCounters::Instructions] / data.perf[PerfCounters::Cycles];
+            } else {
+                ipc << "n/a";
+            }
+            std::cout << std::setw(8) << ipc.str() << std::endl;
+        }
+    }
+
+    static std::string format(int64_t ns) {
+        std::ostringstream os;
+        os << std::fixed << std::setprecision(1);
+        if (ns < 10'000) os << ns << " ns";
+        else if (ns < 10'000'000) os << ns / 1e3 << " us";
+        else if (ns < 10'000'000'000) os << ns / 1e6 << " ms";
+        else os << ns / 1e9 << " s";
+        return os.str();
+    }
+
 private:
-    std::string _name;
+    // Written only by the owning thread, relaxed atomics make concurrent reads well-defined
+    struct TimerSlot {
+        std::atomic<int64_t> ns{0};
+        std::atomic<int64_t> count{0};
+        std::atomic<int64_t> min_ns{std::numeric_limits<int64_t>::max()};
+        std::atomic<int64_t> max_ns{0};
+        std::array<std::atomic<int64_t>, HistogramBuckets> histogram{};
+        std::array<std::atomic<int64_t>, PerfCounters::NumEvents> perf{};
+
+        static void add(std::atomic<int64_t>& x, int64_t v) {
+            x.store(x.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+        }
+
+        void record(int64_t elapsed) {
+            add(ns, elapsed);
+            add(count, 1);
+            add(histogram[bucket(elapsed)], 1);
+            if (elapsed < min_ns.load(std::memory_order_relaxed)) min_ns.store(elapsed, std::memory_order_relaxed);
+            if (elapsed > max_ns.load(std::memory_order_relaxed)) max_ns.store(elapsed, std::memory_order_relaxed);
+        }
+
+        TimerData load() const {
+            TimerData data;
+            data.ns = ns.load(std::memory_order_relaxed);
+            data.count = count.load(std::memory_order_relaxed);
+            data.min_ns = min_ns.load(std::memory_order_relaxed);
+            data.max_ns = max_ns.load(std::memory_order_relaxed);
+            for (int i = 0; i < HistogramBuckets; ++i) data.histogram[i] = histogram[i].load(std::memory_order_relaxed);
+            for (int e = 0; e < PerfCounters::NumEvents; ++e) data.perf[e] = perf[e].load(std::memory_order_relaxed);
+            return data;
+        }
+    };
+
+    struct ThreadTimers;
+
+    struct Registry {
+        std::mutex mutex;
+        std::vector<std::string> names;
+        std::unordered_map<std::string, TimerId> ids;
+        std::vector<ThreadTimers*> live;
+        std::vector<TimerData> finished; // merged slots of exited threads
+    };
+
+    struct ThreadTimers {
+        std::deque<TimerSlot> slots; // deque: growing keeps slots in place
+
+        ThreadTimers() {
+            Registry& r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            r.live.push_back(this);
+        }
+
+        ~ThreadTimers() {
+            Registry& r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            if (r.finished.size() < slots.size()) r.finished.resize(slots.size());
+            for (size_t id = 0; id < slots.size(); ++id) {
+                r.finished[id].merge(slots[id].load());
+            }
+            r.live.erase(std::find(r.live.begin(), r.live.end(), this));
+        }
+
+        TimerSlot& slot(TimerId id) {
+            if (id >= slots.size()) {
+                std::lock_guard<std::mutex> lock(registry().mutex);
+                while (slots.size() <= id) slots.emplace_back();
+            }
+            return slots[id];
+        }
+    };
+
+    static Registry& registry() {
+        static Registry r;
+        return r;
+    }
+
+    static ThreadTimers& threadTimers() {
+        thread_local ThreadTimers timers;
+        return timers;
+    }
+
+    static int bucket(int64_t ns) {
+        if (ns < 16) return std::max<int64_t>(ns, 0);
+        int exponent = std::bit_width(static_cast<uint64_t>(ns)) - 1;
+        int sub = (ns >> (exponent - 3)) & 7;
+        return 16 + (exponent - 4) * 8 + sub;
+    }
+
+    static int64_t bucketMid(int index) {
+        if (index < 16) return index;
+        int exponent = (index - 16) / 8 + 4;
+        int64_t sub = (index - 16) % 8;
+        int64_t lower = (int64_t(8) + sub) << (exponent - 3);
+        return lower + (int64_t(1) << (exponent - 4));
+    }
+
+    TimerId _id;
+    bool _perf;
+    PerfCounters::Values _perf_begin;
     std::chrono::steady_clock::time_point _t_begin;
-    static std::map<std::string, TimerData> _timers;
 };
 
-inline std::map<std::string, ScopedTimer::TimerData> ScopedTimer::_timers;
-
-#endif //TIMER_HPP
\ No newline at end of file
+#endif //TIMER_HPP
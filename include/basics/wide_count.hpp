@@ -0,0 +1,63 @@
+#ifndef WIDE_COUNT_HPP
+#define WIDE_COUNT_HPP
+
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+
+// Four-cycle counts of dense graphs exceed 2^63. Counters accumulate in 64 bit per node
+// and only add the partial sums to a 128 bit total.
+using c4count = __int128;
+
+inline std::string to_string(c4count value) {
+    if (value == 0) return "0";
+    bool negative = value < 0;
+    unsigned __int128 x = negative ? -static_cast<unsigned __int128>(value) : static_cast<unsigned __int128>(value);
+    std::string digits;
+    while (x > 0) {
+        digits.push_back('0' + static_cast<int>(x % 10));
+        x /= 10;
+    }
+    if (negative) digits.push_back('-');
+    return std::string(digits.rbegin(), digits.rend());
+}
+
+inline std::ostream& operator<<(std::ostream& os, c4count value) {
+    return os << to_string(value);
+}
+
+// Output of the estimators, kept in extended precision.
+// Prints as an integer while it fits into c4count and in scientific notation beyond.
+class Estimate {
+public:
+    Estimate(long double value = 0) : _value(value) {}
+
+    long double value() const { return _value; }
+
+    bool fitsInteger() const {
+        return std::isfinite(_value) && std::fabs(_value) < 0x1p126L;
+    }
+
+    c4count integer() const {
+        return static_cast<c4count>(std::roundl(_value));
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const Estimate& e) {
+        if (e.fitsInteger()) {
+            return os << e.integer();
+        }
+        std::ios_base::fmtflags flags = os.flags();
+        std::streamsize precision = os.precision();
+        os << std::scientific << std::setprecision(std::numeric_limits<long double>::digits10) << e._value;
+        os.flags(flags);
+        os.precision(precision);
+        return os;
+    }
+
+private:
+    long double _value;
+};
+
+#endif //WIDE_COUNT_HPP
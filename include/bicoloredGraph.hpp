@@ -8,6 +8,7 @@
 #include <cmath>
 #include <set>
 #include <optional>
+#include "basics/wide_count.hpp"
 
 #ifdef USE_SPARSEHASH
 #include <sparsehash/dense_hash_map>  // Include SparseHash if available
@@ -29,15 +30,23 @@ public:
     void addEdge(int u, int v, int color);
     void removeEdge(int u, int v, int color);
     void removeNode(int u);
+    bool hasEdge(int u, int v, int color) const;
+    const std::vector<node>& neighbors(int u, int color) const { return color == 0 ? _adjList0[u] : _adjList1[u]; }
     
     int n_max() const; //the max node index after node removal
     int m(std::optional<int> color = std::nullopt) const;
     size_t degree(size_t node, std::optional<int> color = std::nullopt) const;
-    long long BiColoredChibaNishizeki();
+    // If perNode is given, it receives the number of colored squares containing each node
+    c4count BiColoredChibaNishizeki(std::vector<long long>* perNode = nullptr);
+    // Heap bytes of the scratch space of the last BiColoredChibaNishizeki call
+    size_t scratchBytes() const { return _scratchBytes; }
+    // Heap bytes of the adjacency lists
+    size_t memory_usage() const;
 
 private: 
     int _num0Edges;     
     int _num1Edges;  
+    size_t _scratchBytes = 0;
     std::vector<std::vector<node>> _adjList0;   // Adjacency list color0
     std::vector<std::vector<node>> _adjList1;   // Adjacency list color1
 
@@ -0,0 +1,46 @@
+#ifndef EIS_HPP
+#define EIS_HPP
+
+// Public API of the eis library.
+//
+// Loading: Graph::read() takes a file name or any std::istream (KONECT or binary format),
+// Graph::addEdge(u, v, true) ingests edges one at a time, e.g. from a message queue.
+// Estimating: Estimator::run() runs any of the algorithms on a loaded graph; the Graph members
+// EIS(), NIS(), multipass_baseline() and countFourCycles() give access to their extra outputs.
+// FusedEstimators runs several sampling estimators with one scan per pass over a loaded graph
+// (EdgeListStream) or a binary graph file (BinaryFileStream); see Estimator::consumer().
+// TurnstileStream holds a fully dynamic stream of edge insertions and deletions.
+// Timers, memory peaks and sample statistics are collected process-wide, see ScopedTimer,
+// MemoryTracker and RunReport. Sample statistics grow with every estimate and are only kept after
+// RunReport::keepSamples(true).
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "graph.hpp"
+#include "fused_estimators.hpp"
+#include "turnstile.hpp"
+#include "generators.hpp"
+#include "memory_budget.hpp"
+#include "basics/random.hpp"
+#include "basics/statistics.hpp"
+#include "basics/wide_count.hpp"
+
+class Estimator {
+public:
+    // EISm is EIS averaged over s samples, 3ES the multipass baseline, Exact the exact count
+    enum class Algorithm { EIS, EISm, NIS, ThreeES, Exact };
+
+    // Names as used by the executables: EIS, EISm, NIS, 3ES, exact
+    static Algorithm parse(const std::string& name);
+    static std::string name(Algorithm algorithm);
+    static std::vector<Algorithm> all();
+
+    // Runs the algorithm once with k sampled edges (EISm: in s samples). Exact ignores k and s.
+    static EstimatorResult run(const Graph& graph, Algorithm algorithm, int k, int s = 1);
+
+    // The algorithm as input of FusedEstimators. There is none for Exact, which is not a streaming algorithm.
+    static std::unique_ptr<EstimatorConsumer> consumer(Algorithm algorithm, int k, int s = 1);
+};
+
+#endif //EIS_HPP
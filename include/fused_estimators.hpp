@@ -0,0 +1,194 @@
+#ifndef FUSED_ESTIMATORS_HPP
+#define FUSED_ESTIMATORS_HPP
+
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <random>
+#include <set>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "graph.hpp"
+#include "EIS_sample.hpp"
+#include "tabulation_hashing.hpp"
+#include "basics/statistics.hpp"
+
+// Source of the edges for the passes of FusedEstimators. Every pass starts with rewind().
+class EdgeStream {
+public:
+    static constexpr size_t BlockSize = 1 << 14;
+
+    virtual ~EdgeStream() = default;
+    // Number of edges of a pass, at least as many as the blocks deliver
+    virtual long long size() const = 0;
+    virtual void rewind() = 0;
+    // Next block of edges, empty at the end of the pass. Valid until the next call.
+    virtual std::span<const Graph::edge> nextBlock() = 0;
+};
+
+// Blocks of an edge list in memory, without copying
+class EdgeListStream : public EdgeStream {
+public:
+    explicit EdgeListStream(const std::vector<Graph::edge>& edges) : _edges(edges) {}
+
+    long long size() const override { return _edges.size(); }
+    void rewind() override { _position = 0; }
+    std::span<const Graph::edge> nextBlock() override;
+
+private:
+    const std::vector<Graph::edge>& _edges;
+    size_t _position = 0;
+};
+
+// Binary graph file (see Graph::read_binary) read one block at a time, so that the graph is never
+// held in memory. Loops are skipped like in Graph::addEdge.
+class BinaryFileStream : public EdgeStream {
+public:
+    explicit BinaryFileStream(const std::string& filename);
+
+    long long n() const { return _n; }
+    long long size() const override { return _m; }
+    void rewind() override;
+    std::span<const Graph::edge> nextBlock() override;
+
+private:
+    std::ifstream _in;
+    std::streampos _edgesBegin;
+    long long _n = 0;
+    long long _m = 0;
+    long long _read = 0;
+    std::vector<uint32_t> _buffer;
+    std::vector<Graph::edge> _block;
+};
+
+// An estimator driven by FusedEstimators. It sees the stream in blocks, in one or two passes, and
+// is used up by estimate(). Random generators are seeded on construction.
+class EstimatorConsumer {
+public:
+    virtual ~EstimatorConsumer() = default;
+
+    // Prefix of the timers of its passes when it scans on its own, e.g. "EIS" for EIS::1st-pass
+    virtual const char* name() const = 0;
+
+    // Called before the first pass with the size of the stream
+    virtual void begin(long long m) {}
+    virtual void firstPass(std::span<const Graph::edge> block) = 0;
+    virtual void endFirstPass() {}
+    virtual bool needsSecondPass() const { return false; }
+    virtual void secondPass(std::span<const Graph::edge> block) {}
+    virtual EstimatorResult estimate() = 0;
+};
+
+// EIS (EISm for s > 1): s reservoirs of k/s edges, the edges induced by them in the second pass
+class EISConsumer : public EstimatorConsumer {
+public:
+    // If localEstimates is given, it receives the average local estimate over the s samples for every sampled node
+    EISConsumer(int k, int s, std::unordered_map<Graph::node, double>* localEstimates = nullptr);
+
+    const char* name() const override { return "EIS"; }
+
+    void begin(long long m) override;
+    void firstPass(std::span<const Graph::edge> block) override;
+    void endFirstPass() override;
+    bool needsSecondPass() const override { return true; }
+    void secondPass(std::span<const Graph::edge> block) override;
+    EstimatorResult estimate() override;
+
+    // Counts the finished samples; their mean is the estimate
+    static EstimatorResult combine(std::vector<Sample>& samples, std::unordered_map<Graph::node, double>* localEstimates);
+
+    // Sharded streams, see Sample::merge(). Both need the same k and s.
+    void merge(const EISConsumer& other);
+    void write(std::ostream& out) const;
+    void read(std::istream& in);
+
+private:
+    int _k;
+    std::vector<Sample> _samples;
+    std::unordered_map<Graph::node, double>* _localEstimates;
+};
+
+// NIS: the k edges whose endpoints have the smallest hashes, counted after a single pass
+class NISConsumer : public EstimatorConsumer {
+public:
+    explicit NISConsumer(int k) : _k(k) {}
+    // Samples of different processes with the same hash seed can be merged
+    NISConsumer(int k, uint64_t hashSeed) : _k(k), _tabHash(hashSeed), _hashSeed(hashSeed) {}
+
+    const char* name() const override { return "NIS"; }
+
+    void firstPass(std::span<const Graph::edge> block) override;
+    EstimatorResult estimate() override;
+
+    // Single edges of the stream; a deleted edge leaves the sample again
+    void insert(const Graph::edge& edge);
+    void erase(const Graph::edge& edge);
+
+    // The sample of two disjoint parts of the stream: the edges of both up to the lower threshold,
+    // reduced to k edges like on insertion. Needs the same k and hash seed.
+    void merge(const NISConsumer& other);
+    void write(std::ostream& out) const;
+    void read(std::istream& in);
+
+private:
+    // Drops the edges with the largest score until at most k are left
+    void shrink();
+
+    int _k;
+    TabHash _tabHash;
+    std::optional<uint64_t> _hashSeed;
+    std::set<std::pair<uint32_t, Graph::edge>> _bst; // ordered by the hash cutoff threshold
+    uint32_t _threshold = std::numeric_limits<uint32_t>::max();
+    long long _m = 0;
+};
+
+// 3ES: a reservoir of k edges, the four-cycles completed by every induced edge of the second pass
+class ThreeESConsumer : public EstimatorConsumer {
+public:
+    explicit ThreeESConsumer(int k);
+
+    const char* name() const override { return "multipass_baseline"; }
+
+    void begin(long long m) override;
+    void firstPass(std::span<const Graph::edge> block) override;
+    void endFirstPass() override;
+    bool needsSecondPass() const override { return true; }
+    void secondPass(std::span<const Graph::edge> block) override;
+    EstimatorResult estimate() override;
+
+private:
+    int _k;
+    std::mt19937 _gen;
+    std::vector<Graph::edge> _reservoir;
+    int _processedEdges = 0;
+    Graph _sampleGraph;
+    std::unordered_map<int, int> _sampleNodes; // original id -> id in the sample graph
+    c4count _sampleCount = 0;
+    long long _m = 0;
+};
+
+// Runs several estimators with one scan of the stream per pass: every block is read once and handed
+// to all estimators before the next one is read. A second pass only happens if one of them needs it.
+class FusedEstimators {
+public:
+    // Returns the position of the estimator in the results of run()
+    size_t add(std::unique_ptr<EstimatorConsumer> consumer);
+    size_t size() const { return _consumers.size(); }
+
+    // Both passes over the stream, then the estimate of every estimator. Uses up the estimators added so far.
+    std::vector<EstimatorResult> run(EdgeStream& stream);
+
+    // The passes of run() and the estimate of the i-th estimator, which is then used up.
+    // Lets the caller attribute what each estimator reports, see RunReport::setRun().
+    // A single estimator times its passes under its own name, several share FusedEstimators::*.
+    void scan(EdgeStream& stream);
+    EstimatorResult estimate(size_t i);
+
+private:
+    std::vector<std::unique_ptr<EstimatorConsumer>> _consumers;
+};
+
+#endif //FUSED_ESTIMATORS_HPP
@@ -0,0 +1,58 @@
+#ifndef GENERATORS_HPP
+#define GENERATORS_HPP
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "graph.hpp"
+
+// Seeded random graph generators. Edges are produced in fixed-size blocks with one seed per block,
+// so the output only depends on the seed and not on the number of threads generating it in parallel.
+// Generated graphs contain no loops and no parallel edges: repeated edges are drawn again, in block
+// order, so that also takes a set of all edges generated so far. Config::multigraph keeps them
+// instead, like KONECT multigraphs, and streams in constant memory per block.
+class GraphGenerator {
+public:
+    enum class Model { ErdosRenyi, ChungLu, RMAT, Bipartite };
+    enum class Format { Konect, Binary };
+
+    struct Config {
+        Model model = Model::ErdosRenyi;
+        long long n = 0;          // nodes (R-MAT: rounded up to a power of two; Bipartite: left side)
+        long long nRight = 0;     // Bipartite: nodes of the right side
+        long long m = 0;          // edges
+        double exponent = 2.5;    // Chung-Lu: power-law exponent of the expected degrees
+        double a = 0.57, b = 0.19, c = 0.19; // R-MAT quadrant probabilities, d = 1-a-b-c
+        uint64_t seed = 0;
+        bool multigraph = false;  // keep parallel edges
+    };
+
+    static constexpr long long BlockSize = 1 << 20;
+    // Simple graphs: average redraws of repeated edges per edge of a block before giving up,
+    // when the model leaves hardly any new pair
+    static constexpr long long RedrawsPerEdge = 64;
+
+    explicit GraphGenerator(const Config& config);
+
+    // Number of nodes of the generated graph (both sides for bipartite graphs)
+    long long n() const;
+
+    std::vector<Graph::edge> generate() const;
+    // Streams the graph to a file in blocks, without holding all edges in memory
+    void write(const std::string& filename, Format format) const;
+
+private:
+    Config _config;
+    int _scale = 0; // R-MAT: log2 of the number of nodes
+
+    // A random edge of the model, possibly a loop
+    Graph::edge draw(std::mt19937_64& gen) const;
+    void generateBlock(long long block, std::vector<Graph::edge>& edges) const;
+    // Replaces the edges of a block that are in seen by new ones and adds the rest to seen.
+    // Blocks have to be passed in order.
+    void removeRepeated(long long block, Graph::edge* edges, size_t count, std::unordered_set<uint64_t>& seen) const;
+};
+
+#endif
@@ -8,6 +8,8 @@
 #include <unordered_map>
 #include <cmath>
 #include <optional>
+#include "basics/wide_count.hpp"
+#include "basics/statistics.hpp"
 
 #ifdef USE_SPARSEHASH
 #include <sparsehash/dense_hash_map>  // Include SparseHash if available
@@ -25,29 +27,111 @@ public:
     using mapIntLL = std::unordered_map<node, long long>; 
 #endif
 
+    struct CoreDecomposition {
+        int degeneracy = 0;
+        std::vector<int> core;    // core number of every node
+        std::vector<node> order;  // degeneracy order, every node has at most `degeneracy` neighbors later in the order
+    };
+
+    // Result of countFourCycles(). Local counts are only filled if requested.
+    struct FourCycleCounts {
+        c4count total = 0;
+        std::vector<long long> perNode;  // four-cycles containing the node
+        std::vector<long long> perEdge;  // four-cycles containing the edge, indexed like edges()
+    };
+
+    // Which endpoint of an edge is the higher one in countFourCycles()
+    enum class Orientation { Degree, Degeneracy };
+
+    // Node orders available for relabeling, see relabel()
+    enum class NodeOrdering { Degree, Degeneracy, RCM, Gorder };
+
 
     // Add undirected edge. If incremental is set, allocate new space if unseen node appears
     void addEdge(node u, node v, bool incremental=false);
     void read_konect(const std::string& filename);
+    void read_konect(std::istream& in);
+    // Binary format: magic "EISGRAPH", uint64 n, uint64 m, then m pairs of 0-based uint32 node ids
+    void read_binary(const std::string& filename);
+    void read_binary(std::istream& in);
+    // Picks the reader by the contents; the file name "-" reads from stdin
+    void read(const std::string& filename);
+    void read(std::istream& in);
+    static void readBinaryHeader(std::istream& in, long long& n, long long& m);
+    static void writeBinaryHeader(std::ostream& out, long long n, long long m);
 
     int n() const;
     int m() const;
+    const std::vector<edge>& edges() const;
+    // Time of every edge, indexed like edges(): the 4th column of KONECT files; empty if there is none
+    const std::vector<long long>& timestamps() const;
     size_t degree(size_t node) const;
     size_t maxdegree() const;
 
     int computeDegeneracy() const;
-    long long ChibaNishizeki();
+    std::vector<node> degeneracyOrder() const;
+    // Batagelj-Zaversnik bucket peeling in O(n+m)
+    CoreDecomposition computeCoreDecomposition() const;
+    // Level-synchronous parallel peeling (PKC/ParK style), same core numbers
+    CoreDecomposition computeCoreDecompositionParallel() const;
+
+    // Order of the nodes (position -> current id) under the given ordering
+    std::vector<node> computeOrdering(NodeOrdering ordering) const;
+    // Permanently relabels the nodes such that node order[i] becomes node i.
+    // Rewrites _adjList and _edgeList; originalId() maps back to input ids.
+    void relabel(NodeOrdering ordering);
+    node originalId(node u) const;
+    // Id of a node in the input file: 1-based, for bipartite KONECT files per side with an L or R prefix
+    std::string inputId(node u) const;
 
-    long long EIS(int k, int s) const;
+    c4count ChibaNishizeki();
+    // Exact counting over oriented wedges, in parallel if OpenMP is available
+    FourCycleCounts countFourCycles(bool local = false, Orientation orientation = Orientation::Degree) const;
+    // The adjacency of countFourCycles() as a file for ShardedCount: nodes renumbered by their rank in
+    // the degree orientation, sorted neighbor lists without parallel edges. After RankedCSRMagic, the
+    // number of nodes n and of neighbor entries as uint64, then n+1 uint64 offsets and the int32 neighbors.
+    void writeRankedCSR(const std::string& filename) const;
+    static constexpr char RankedCSRMagic[8] = {'E', 'I', 'S', 'R', 'A', 'N', 'K', 'S'};
 
-    long long NIS(int k) const;
+    // The estimators return the mean over their samples together with the estimate of every sample.
+    // If localEstimates is given, it receives the average local estimate over the s samples for every sampled node
+    EstimatorResult EIS(int k, int s, std::unordered_map<node, double>* localEstimates = nullptr) const;
 
-    long long multipass_baseline(int k) const;
+    EstimatorResult NIS(int k) const;
+
+    EstimatorResult multipass_baseline(int k) const;
     long long countSquaresCompletedByEdge(node u,node v) const;
 
+    // Updates that keep an exact four-cycle count: each one adjusts it by the four-cycles through
+    // the edge. The first update sorts the adjacency lists, drops repeated edges from the edge list
+    // and counts from scratch, and so does the first one after addEdge() or relabel(). Timestamps are dropped.
+    void insertEdge(node u, node v);
+    void deleteEdge(node u, node v);
+    // Four-cycles of the graph, kept up to date by insertEdge() and deleteEdge(); counted if neither ran yet
+    c4count fourCycles() const;
+    // Four-cycles the missing edge {u, v} would close: paths u - a - b - v, found by intersecting
+    // the sorted neighbor lists of the a with that of v
+    long long fourCyclesClosedBy(node u, node v) const;
+
+    // Heap bytes of the adjacency lists, the edge list and the relabeling
+    size_t memory_usage() const;
+
 private:
     std::vector<std::vector<node>> _adjList;
     std::vector<edge> _edgeList;
+    std::vector<node> _originalId; // empty as long as the graph was never relabeled
+    node _nLeft = 0; // nodes of the left side of a bipartite input, which come first; 0 otherwise
+    std::vector<long long> _timestamps;
+    std::optional<c4count> _fourCycles; // count of insertEdge()/deleteEdge(), empty until their first use
+    std::unordered_map<uint64_t, size_t> _edgeIndex; // position in _edgeList, kept while _fourCycles is
+
+    static constexpr char BinaryMagic[8] = {'E', 'I', 'S', 'G', 'R', 'A', 'P', 'H'};
+    void finalizeAdjacency();
+    void startFourCycleCount();
+    static uint64_t edgeKey(node u, node v);
+
+    std::vector<node> rcmOrder() const;
+    std::vector<node> gorderOrder(int window = 5) const;
 
 };
 
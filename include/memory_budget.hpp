@@ -0,0 +1,47 @@
+#ifndef MEMORY_BUDGET_HPP
+#define MEMORY_BUDGET_HPP
+
+#include <string>
+#include "graph.hpp"
+
+// Chooses the sample size k (and the number of EISm samples s) that fits a memory budget.
+// The model charges every sampled edge for the memory that lives as long as its sample
+// (reservoir slot, node mapping, both colors of the adjacency lists) and every edge of the
+// sample being counted for the scratch space of BiColoredChibaNishizeki. Only one sample is
+// counted at a time, so EIS with k edges in s samples needs
+//     k * sampleBytesPerEdge + k/s * scratchBytesPerEdge
+// on top of what the process already uses.
+class MemoryBudget {
+public:
+    struct Model {
+        double sampleBytesPerEdge;
+        double scratchBytesPerEdge;
+    };
+
+    struct Choice {
+        int k;
+        int s;
+    };
+
+    // Worst case of the data structures on a 64 bit platform
+    static Model defaultModel();
+
+    // Measures the model on a sample of the given graph, about a sixteenth of the size the
+    // default model allows. The sample memory is linear in k and taken with a 10% margin;
+    // the measured scratch never lowers the default one, since the wedge maps grow faster
+    // than linearly with the sample size.
+    static Model calibrate(const Graph& graph, size_t budget);
+
+    // Largest k fitting into budget bytes given the memory in use now. For maxS > 1 the split
+    // minimizes s/k^2, which is proportional to the variance of the averaged estimate when the
+    // four-cycles of the samples are independent, and is at most maxS.
+    static Choice choose(const Graph& graph, size_t budget, int maxS, const Model& model);
+
+    // With --mem-budget, replaces k and s of the parameters by the choice for the given graph
+    static void applyParameters(const Graph& graph, int maxS);
+
+    // Parses sizes like 512M, 2G or 1073741824 (suffixes K, M, G, T are powers of 1024)
+    static size_t parse(const std::string& size);
+};
+
+#endif //MEMORY_BUDGET_HPP
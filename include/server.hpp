@@ -0,0 +1,74 @@
+#ifndef SERVER_HPP
+#define SERVER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include "graph.hpp"
+
+// Answers estimate requests for graphs held in memory over a Unix domain socket (eisd).
+// A connection sends one request per line and receives one response line per request:
+//     estimate GRAPH ALGORITHM K [S [REPS]]  ->  ok ESTIMATE CI_LOW CI_HIGH MILLISECONDS
+//     load GRAPH FILE                        ->  ok N M
+//     graphs                                 ->  ok GRAPH:N:M ...
+//     ping                                   ->  ok
+//     shutdown                               ->  ok
+// The 95% confidence interval is over the repetitions if there are several, otherwise over the
+// samples of the one run (EISm). A single sample has none, its bounds are "nan nan". Exact counts
+// are answered with the count as both bounds.
+// Failed requests are answered with "error MESSAGE". Connections are served by a fixed pool of
+// workers, so requests on different connections run concurrently.
+class EstimateServer {
+public:
+    // Reads the graph and makes it available under the name, replacing a graph of the same name.
+    // Requests running on the replaced graph finish on it.
+    void load(const std::string& name, const std::string& filename);
+
+    // The response line to a request line, without the newline
+    std::string handle(const std::string& request);
+
+    // Serves until a shutdown request or stop(). The socket file is replaced and removed on exit.
+    // Every worker runs the parallel code paths of its requests with the given number of OpenMP
+    // threads; 0 divides the hardware threads among the workers.
+    void serve(const std::string& socketPath, int workers, int threads = 0);
+    void stop();
+
+private:
+    std::shared_ptr<const Graph> graph(const std::string& name) const;
+    std::string estimate(const std::vector<std::string>& words);
+    void serveConnection(int fd);
+
+    mutable std::shared_mutex _graphsMutex;
+    std::map<std::string, std::shared_ptr<const Graph>> _graphs;
+
+    std::atomic<bool> _stopping = false;
+    std::atomic<int> _listenFd = -1;
+    std::mutex _connectionsMutex;
+    std::condition_variable _connectionReady;
+    std::deque<int> _pending;
+    std::set<int> _active;
+};
+
+// Sends request lines to an EstimateServer (eis-client)
+class EstimateClient {
+public:
+    explicit EstimateClient(const std::string& socketPath);
+    ~EstimateClient();
+    EstimateClient(const EstimateClient&) = delete;
+    EstimateClient& operator=(const EstimateClient&) = delete;
+
+    // The response line, without the newline
+    std::string request(const std::string& line);
+
+private:
+    int _fd = -1;
+    std::string _buffer;
+};
+
+#endif //SERVER_HPP
@@ -0,0 +1,48 @@
+#ifndef SHARDED_COUNT_HPP
+#define SHARDED_COUNT_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "basics/wide_count.hpp"
+
+// Exact four-cycle counting split over processes that share the graph through a CSR file written
+// by Graph::writeRankedCSR. Like countFourCycles(), every cycle is counted at its highest ranked
+// node; the ranks are split into P contiguous shards of about equal wedge work, and the worker of
+// a shard maps the file read-only, so it only pages in the neighbor lists its wedges pass through.
+// The partial counts add up to the total. Workers may run on other machines with a copy of the file.
+class ShardedCount {
+public:
+    // Read-only memory mapping of a ranked CSR file
+    class MappedCSR {
+    public:
+        explicit MappedCSR(const std::string& filename);
+        ~MappedCSR();
+        MappedCSR(const MappedCSR&) = delete;
+        MappedCSR& operator=(const MappedCSR&) = delete;
+
+        int n() const { return _n; }
+        // Neighbors of rank u are neighbors()[offsets()[u]] up to neighbors()[offsets()[u + 1]], sorted
+        const uint64_t* offsets() const { return _offsets; }
+        const int32_t* neighbors() const { return _neighbors; }
+
+    private:
+        void* _data = nullptr;
+        size_t _size = 0;
+        int _n = 0;
+        const uint64_t* _offsets = nullptr;
+        const int32_t* _neighbors = nullptr;
+    };
+
+    // First rank of every shard, then n. The same in every process, but it walks the whole file,
+    // so the coordinator computes it once and passes the ranges on.
+    static std::vector<int> shardBounds(const MappedCSR& csr, int shards);
+    // Four-cycles whose highest ranked node lies in [from, to), in parallel if OpenMP is available
+    static c4count countRanks(const std::string& csrFile, int from, int to);
+    // Starts workerCommand + {"--shard", i, "--from", bounds[i], "--to", bounds[i + 1]} as a process
+    // for every shard, each printing its countRanks() on stdout, and sums up what they print.
+    // Throws if a worker fails.
+    static c4count run(const std::vector<std::string>& workerCommand, const std::vector<int>& bounds);
+};
+
+#endif //SHARDED_COUNT_HPP
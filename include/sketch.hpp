@@ -0,0 +1,45 @@
+#ifndef SKETCH_HPP
+#define SKETCH_HPP
+
+#include <cstdint>
+#include <string>
+#include "fused_estimators.hpp"
+#include "basics/statistics.hpp"
+
+// Mergeable EIS (EISm) and NIS samples of a stream whose edges are spread over several shards:
+//   1. every shard runs the first pass over its edges (sample()) and writes its sketch,
+//   2. a coordinator merges these sketches,
+//   3. every shard runs the second pass of EIS over its edges on the merged sketch (induce()),
+//   4. the coordinator merges the results and counts.
+// NIS needs no second pass; the sketches of step 3 carry the NIS sample of step 2 unchanged, and
+// merging them keeps it instead of adding it up again. The shards need the same hash seed for NIS
+// but different random streams for the EIS reservoirs.
+class Sketch {
+public:
+    enum class Phase : uint8_t { Sampled, Induced };
+
+    Sketch(int k, int s, uint64_t hashSeed);
+    explicit Sketch(const std::string& filename);
+    void write(const std::string& filename) const;
+
+    Phase phase() const { return _phase; }
+    // First pass over the edges of one shard
+    void sample(EdgeStream& stream);
+    // Second pass over the edges of one shard, on the merged sketches of all first passes
+    void induce(EdgeStream& stream);
+    // Sketches of the same phase and parameters
+    void merge(const Sketch& other);
+
+    // Use up the samples
+    EstimatorResult estimateEIS();
+    EstimatorResult estimateNIS();
+
+private:
+    static constexpr char Magic[8] = {'E', 'I', 'S', 'K', 'E', 'T', 'C', 'H'};
+
+    Phase _phase = Phase::Sampled;
+    EISConsumer _eis;
+    NISConsumer _nis;
+};
+
+#endif //SKETCH_HPP
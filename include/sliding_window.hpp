@@ -0,0 +1,68 @@
+#ifndef SLIDING_WINDOW_HPP
+#define SLIDING_WINDOW_HPP
+
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <set>
+#include <unordered_map>
+#include <vector>
+#include "graph.hpp"
+#include "tabulation_hashing.hpp"
+#include "basics/wide_count.hpp"
+
+// Four-cycle estimates over the edges of a timestamped stream that arrived in the last `window`
+// time units. Like NIS, the sample holds the edges of the window whose endpoints both hash to at
+// most a threshold, so it is the subgraph of the window induced by a random node set: a four-cycle
+// of the window is sampled with probability p^4 for p the fraction of hash values up to the
+// threshold. When the sample exceeds k edges, the threshold drops below the largest hash in it.
+// The sample is a Graph whose four-cycles insertEdge() and deleteEdge() update on every insertion
+// and expiry, so estimates are available at any time without recounting. Repeated edges count once while a copy of them is in the window.
+// The threshold never rises again, so if the window gets sparser the sample stays below k edges.
+class SlidingWindowEstimator {
+public:
+    // k <= 0 keeps every edge of the window, which makes the estimate exact
+    SlidingWindowEstimator(long long window, int k);
+
+    // Edges have to arrive in timestamp order
+    void insert(Graph::node u, Graph::node v, long long timestamp);
+    // Expires the edges up to time - window; insert() does this as well
+    void advance(long long time);
+
+    Estimate estimate() const;
+    c4count sampleFourCycles() const { return _sample.fourCycles(); }
+    // Distinct edges in the sample
+    long long sampleEdges() const { return _byScore.size(); }
+    // Arrivals in the window, repeated edges included
+    long long windowEdges() const { return _windowEdges; }
+    size_t memory_usage() const;
+
+private:
+    struct Arrival {
+        long long timestamp;
+        Graph::node u, v;
+        uint32_t score;
+    };
+
+    static uint64_t key(Graph::node u, Graph::node v);
+    // Node of the sample graph for node u of the stream, assigned on first use
+    Graph::node sampleId(Graph::node u);
+    void addSampleEdge(Graph::node u, Graph::node v);
+    void removeSampleEdge(Graph::node u, Graph::node v);
+
+    long long _window;
+    int _k;
+    TabHash _tabHash;
+    uint32_t _threshold = std::numeric_limits<uint32_t>::max();
+
+    std::deque<std::pair<long long, long long>> _arrivals; // (timestamp, arrivals) of the window
+    long long _windowEdges = 0;
+    std::deque<Arrival> _sampled; // arrivals with a score up to the threshold at their time
+    std::unordered_map<uint64_t, int> _copies; // sampled arrivals of each distinct edge
+    std::set<std::pair<uint32_t, uint64_t>> _byScore; // distinct edges of the sample
+    Graph _sample; // over compact ids, freed again when a node loses its last sampled edge
+    std::unordered_map<Graph::node, Graph::node> _sampleIds;
+    std::vector<Graph::node> _freeIds;
+};
+
+#endif //SLIDING_WINDOW_HPP
@@ -4,6 +4,7 @@
 #include <array>
 #include <cstdint>
 #include <random>
+#include "basics/random.hpp"
 
 class TabHash {
 public:
@@ -15,6 +16,11 @@ public:
         Reset();
     }
 
+    // Tables determined by the seed alone, the same in every process
+    explicit TabHash(uint64_t seed) {
+        Reset(seed);
+    }
+
     // Hash functions
     uint32_t Simple(uint32_t x) const {
         const auto& H = simpleTable;
@@ -44,26 +50,31 @@ public:
 
     // Reset the tables with new random values
     void Reset() {
-        simpleTable = SetupSimple();
-        twistedTable = SetupTwisted();
+        simpleTable = SetupSimple(Seeds::next());
+        twistedTable = SetupTwisted(Seeds::next());
+    }
+
+    void Reset(uint64_t seed) {
+        simpleTable = SetupSimple(seed);
+        twistedTable = SetupTwisted(seed ^ 0x9e3779b97f4a7c15ULL);
     }
 
 private:
     SimpleTable simpleTable;
     TwistedTable twistedTable;
 
-    SimpleTable SetupSimple() {
+    SimpleTable SetupSimple(uint64_t seed) {
         SimpleTable table;
-        std::mt19937 rng(std::random_device{}());
+        std::mt19937 rng(seed);
         for (auto& row : table)
             for (auto& cell : row)
                 cell = static_cast<uint32_t>(rng());
         return table;
     }
 
-    TwistedTable SetupTwisted() {
+    TwistedTable SetupTwisted(uint64_t seed) {
         TwistedTable table;
-        std::mt19937_64 rng(std::random_device{}());
+        std::mt19937_64 rng(seed);
         for (auto& row : table)
             for (auto& cell : row)
                 cell = rng();
@@ -0,0 +1,77 @@
+#ifndef TURNSTILE_HPP
+#define TURNSTILE_HPP
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "graph.hpp"
+#include "basics/statistics.hpp"
+
+// Insertion (sign +1) or deletion (sign -1) of an edge in a fully dynamic (turnstile) stream
+struct EdgeUpdate {
+    Graph::node u, v;
+    int sign;
+};
+
+// Uniform sample of at most `capacity` edges of the current graph of a turnstile stream (random
+// pairing, Gemulla et al. 2006). Deletions leave uncompensated slots that later insertions fill
+// with the probability that keeps the sample uniform, instead of shrinking the sample for good.
+class RandomPairingReservoir {
+public:
+    explicit RandomPairingReservoir(int capacity);
+
+    void update(const EdgeUpdate& update);
+    // In arbitrary order
+    const std::vector<Graph::edge>& edges() const { return _edges; }
+    // Edges of the current graph
+    long long streamSize() const { return _size; }
+    size_t memory_usage() const;
+
+private:
+    static uint64_t key(Graph::node u, Graph::node v);
+    void add(const Graph::edge& edge);
+
+    int _capacity;
+    std::mt19937_64 _gen;
+    std::vector<Graph::edge> _edges;
+    std::unordered_map<uint64_t, size_t> _position; // index of every sampled edge in _edges
+    long long _size = 0;
+    long long _sampledDeletions = 0;   // uncompensated deletions of sampled edges
+    long long _unsampledDeletions = 0; // and of edges outside the sample
+};
+
+// A turnstile stream of edge updates. Estimators make the same number of passes over the updates
+// as over an insert-only stream and estimate the four-cycles of the graph left at the end:
+// EIS and 3ES sample with random pairing in the first pass; NIS keeps the edges whose endpoints
+// hash below its threshold, which a deletion simply removes again.
+class TurnstileStream {
+public:
+    // Lines "u v sign [timestamp]" with 1-based node ids and sign +1 or -1, the KONECT layout of
+    // dynamic networks. Lines starting with % are comments. Every insertion must be of an edge
+    // that is not in the graph and every deletion of one that is.
+    void read(const std::string& filename);
+    void read(std::istream& in);
+    void addUpdate(Graph::node u, Graph::node v, int sign);
+
+    const std::vector<EdgeUpdate>& updates() const { return _updates; }
+    int n() const { return _n; }
+    // Edges left at the end
+    int m() const { return _edges.size(); }
+    // The graph left at the end, for exact counts
+    Graph finalGraph() const;
+
+    EstimatorResult EIS(int k, int s) const;
+    EstimatorResult NIS(int k) const;
+    EstimatorResult multipass_baseline(int k) const;
+
+private:
+    static uint64_t key(Graph::node u, Graph::node v);
+
+    std::vector<EdgeUpdate> _updates;
+    std::unordered_map<uint64_t, Graph::edge> _edges; // the current graph while reading
+    int _n = 0;
+};
+
+#endif //TURNSTILE_HPP
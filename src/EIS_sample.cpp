@@ -1,7 +1,12 @@
 #include "EIS_sample.hpp"
+#include <algorithm>
 #include <iostream>
+#include "basics/random.hpp"
+#include "basics/memory.hpp"
+#include "basics/serialize.hpp"
+#include <stdexcept>
 
-Sample::Sample() : gen(rd()) {}
+Sample::Sample() : gen(Seeds::next()) {}
 
 void Sample::setupReservoirSampling(int s) {
     space = s;
@@ -28,11 +33,14 @@ void Sample::processForReservoirSampling(edge edge) {
 }
 
 void Sample::finalizeReservoirSampling() {
+    // the stream may have been shorter than the reservoir
+    reservoir.resize(std::min<size_t>(reservoir.size(), processedEdges));
     for (const auto& [u, v] : reservoir) {
         int mappedU = getMappedNode(u);
         int mappedV = getMappedNode(v);
         graph.addEdge(mappedU, mappedV, 0);
     }
+    finalized = true;
 }
 
 void Sample::collectInducedEge(edge edge) {
@@ -46,34 +54,178 @@ void Sample::collectInducedEge(edge edge) {
     }
     while (graph.m(1) > space) {
         // Delete last sampledEdge until below space
-        auto [x, y] = reservoir.back();
-        reservoir.pop_back();
+        dropLastSampledEdge();
+    }
+}
 
-        int mappedx = getMappedNode(x);
-        int mappedy = getMappedNode(y);
+void Sample::dropLastSampledEdge() {
+    auto [x, y] = reservoir.back();
+    reservoir.pop_back();
 
-        // Remove edge from the graph
-        graph.removeEdge(mappedx, mappedy, 0);
-        removedsampledEdges++;
+    int mappedx = getMappedNode(x);
+    int mappedy = getMappedNode(y);
 
-        // Check if nodes have no more sampled edges and delete
-        if (graph.degree(mappedx, 0) == 0) {
-            graph.removeNode(mappedx);
-            removedNodes++;
-        }
-        if (graph.degree(mappedy, 0) == 0) {
-            graph.removeNode(mappedy);
-            removedNodes++;
+    // Remove edge from the graph
+    graph.removeEdge(mappedx, mappedy, 0);
+    removedsampledEdges++;
+
+    // Check if nodes have no more sampled edges and delete
+    if (graph.degree(mappedx, 0) == 0) {
+        graph.removeNode(mappedx);
+        removedNodes++;
+    }
+    if (graph.degree(mappedy, 0) == 0) {
+        graph.removeNode(mappedy);
+        removedNodes++;
+    }
+}
+
+void Sample::setupFromReservoir(const std::vector<edge>& edges, int space, int streamsize) {
+    setupReservoirSampling(space);
+    reservoir = edges;
+    // sampled edges are dropped from the back when the induced edges exceed the space
+    std::shuffle(reservoir.begin(), reservoir.end(), gen);
+    processedEdges = streamsize;
+    this->streamsize = streamsize;
+    finalizeReservoirSampling();
+}
+
+void Sample::collectInducedUpdate(edge edge, int sign) {
+    if (sign > 0) {
+        collectInducedEge(edge);
+        return;
+    }
+    auto [u, v] = edge;
+    auto itU = nodeMapping.find(u);
+    auto itV = nodeMapping.find(v);
+    if (itU == nodeMapping.end() or itV == nodeMapping.end()) return; // not induced
+    if (graph.hasEdge(itU->second, itV->second, 1)) {
+        graph.removeEdge(itU->second, itV->second, 1);
+    }
+}
+
+void Sample::merge(const Sample& other) {
+    if (space != other.space) throw std::invalid_argument("Cannot merge samples of different space.");
+    if (finalized != other.finalized) throw std::invalid_argument("Cannot merge samples of different passes.");
+    if (not finalized) {
+        mergeReservoir(other);
+        return;
+    }
+    // Both second passes dropped sampled edges from the back of the same reservoir
+    const size_t common = std::min(reservoir.size(), other.reservoir.size());
+    if (streamsize != other.streamsize or not std::equal(reservoir.begin(), reservoir.begin() + common, other.reservoir.begin())) {
+        throw std::invalid_argument("Cannot merge second passes over different samples.");
+    }
+    while (reservoir.size() > common) {
+        dropLastSampledEdge();
+    }
+    for (const auto& edge : other.inducedEdges()) {
+        collectInducedEge(edge);
+    }
+}
+
+void Sample::mergeReservoir(const Sample& other) {
+    std::vector<edge> parts[2] = {
+        {reservoir.begin(), reservoir.begin() + std::min<size_t>(reservoir.size(), processedEdges)},
+        {other.reservoir.begin(), other.reservoir.begin() + std::min<size_t>(other.reservoir.size(), other.processedEdges)}};
+    // Draws without replacement from the union of both parts of the stream: every draw hits a part
+    // with the share of its edges not drawn yet, and then the next edge of its shuffled reservoir
+    long long left[2] = {processedEdges, other.processedEdges};
+    size_t taken[2] = {0, 0};
+    const size_t size = std::min<long long>(space, left[0] + left[1]);
+    for (auto& part : parts) {
+        std::shuffle(part.begin(), part.end(), gen);
+    }
+    std::vector<edge> merged;
+    merged.reserve(space);
+    while (merged.size() < size) {
+        std::uniform_int_distribution<long long> dist(0, left[0] + left[1] - 1);
+        const int part = dist(gen) < left[0] ? 0 : 1;
+        merged.push_back(parts[part][taken[part]++]);
+        left[part]--;
+    }
+    merged.resize(space);
+    reservoir = std::move(merged);
+    processedEdges += other.processedEdges;
+    streamsize += other.streamsize;
+}
+
+std::vector<Sample::edge> Sample::inducedEdges() const {
+    std::vector<node> original(nextNode);
+    for (const auto& [u, mapped] : nodeMapping) {
+        original[mapped] = u;
+    }
+    std::vector<edge> edges;
+    for (node u = 0; u < graph.n_max(); ++u) {
+        for (node v : graph.neighbors(u, 1)) {
+            if (u < v) edges.emplace_back(original[u], original[v]);
         }
     }
+    return edges;
+}
+
+void Sample::write(std::ostream& out) const {
+    Binary::write<int>(out, space);
+    Binary::write<int>(out, processedEdges);
+    Binary::write<int>(out, streamsize);
+    Binary::write<uint8_t>(out, finalized);
+    Binary::write(out, std::vector<edge>(reservoir.begin(), reservoir.begin() + std::min<size_t>(reservoir.size(), processedEdges)));
+    if (finalized) {
+        Binary::write(out, inducedEdges());
+        Binary::write<int>(out, removedsampledEdges);
+        Binary::write<int>(out, removedNodes);
+    }
+}
+
+void Sample::read(std::istream& in) {
+    graph = BiColoredGraph();
+    nextNode = 0;
+    setupReservoirSampling(Binary::read<int>(in));
+    processedEdges = Binary::read<int>(in);
+    streamsize = Binary::read<int>(in);
+    finalized = Binary::read<uint8_t>(in);
+    reservoir = Binary::readEdges(in);
+    if (not finalized) {
+        reservoir.resize(space); // the first pass may go on
+        return;
+    }
+    finalizeReservoirSampling();
+    for (const auto& edge : Binary::readEdges(in)) {
+        collectInducedEge(edge);
+    }
+    removedsampledEdges = Binary::read<int>(in);
+    removedNodes = Binary::read<int>(in);
 }
 
-long long Sample::estimate() {
+size_t Sample::memory_usage() const {
+    return graph.memory_usage() + Memory::of(nodeMapping) + Memory::of(reservoir);
+}
+
+SampleStats Sample::stats() const {
+    return {static_cast<long long>(reservoir.size()), graph.m(1), removedsampledEdges, removedNodes};
+}
+
+Estimate Sample::estimate(std::unordered_map<node, double>* localEstimates) {
     int finalreservoirsize = reservoir.size();
-    auto sampleCount = graph.BiColoredChibaNishizeki();
+    std::vector<long long> perNode;
+    auto sampleCount = graph.BiColoredChibaNishizeki(localEstimates ? &perNode : nullptr);
+    MemoryTracker::record("BiColoredChibaNishizeki", graph.scratchBytes());
 
     double prob = 1.0 * finalreservoirsize / streamsize;
     // each four cycle is counted for 2 pairs
-    long long estimate = prob > 0 ? std::llround(sampleCount / prob / prob / 2) : 0;
+    Estimate estimate = prob > 0 ? static_cast<long double>(sampleCount) / prob / prob / 2 : 0;
+
+    if (localEstimates and prob > 0) {
+        // a four cycle through a node is sampled with the same probability as any other four cycle
+        for (const auto& [original, mapped] : nodeMapping) {
+            if (graph.degree(mapped, 0) == 0) continue; // removed from the sample
+            (*localEstimates)[original] = perNode[mapped] / prob / prob / 2;
+        }
+    }
     return estimate;
-}
\ No newline at end of file
+}
+
+size_t Sample::countingScratch() {
+    graph.BiColoredChibaNishizeki();
+    return graph.scratchBytes();
+}
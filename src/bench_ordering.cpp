@@ -0,0 +1,42 @@
+#include "graph.hpp"
+#include <iostream>
+#include <basics/parms.hpp>
+#include <basics/timer.hpp>
+
+// Compares the running time of exact counting under the different node relabelings.
+
+int main(int argc, char **argv) {
+    Parms.read_parameters(argc,argv);
+    {
+        ScopedTimer t1("main");
+
+        Graph graph;
+        {
+            ScopedTimer t2("IO");
+            graph.read(Parms.input());
+        }
+
+        const std::vector<std::pair<std::string, std::optional<Graph::NodeOrdering>>> orderings = {
+            {"input", std::nullopt},
+            {"degree", Graph::NodeOrdering::Degree},
+            {"degeneracy", Graph::NodeOrdering::Degeneracy},
+            {"rcm", Graph::NodeOrdering::RCM},
+            {"gorder", Graph::NodeOrdering::Gorder},
+        };
+
+        for (const auto& [name, ordering] : orderings) {
+            Graph relabeled = graph;
+            if (ordering.has_value()) {
+                ScopedTimer t("relabel::" + name);
+                relabeled.relabel(ordering.value());
+            }
+            for (int i = 0; i < Parms.reps(); ++i) {
+                ScopedTimer t("ChibaNishizeki::" + name);
+                c4count count = relabeled.ChibaNishizeki();
+                std::cout << name << "\t" << count << std::endl;
+            }
+        }
+    }
+    ScopedTimer::print_timers();
+    return 0;
+}
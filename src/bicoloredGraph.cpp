@@ -13,6 +13,7 @@
 #include <iostream>
 #include "basics/timer.hpp"
 #include "basics/parms.hpp"
+#include "basics/memory.hpp"
 
 
 void BiColoredGraph::addEdge(int u, int v, int color)
@@ -61,6 +62,12 @@ void BiColoredGraph::removeNode(int u) {
 }
 
 
+bool BiColoredGraph::hasEdge(int u, int v, int color) const {
+    if (u >= _adjList0.size() || v >= _adjList0.size()) return false;
+    const auto& neighbors = color == 0 ? _adjList0[u] : _adjList1[u];
+    return std::find(neighbors.begin(), neighbors.end(), v) != neighbors.end();
+}
+
 int BiColoredGraph::n_max() const {
     return _adjList0.size();
 }
@@ -79,10 +86,15 @@ size_t BiColoredGraph::degree(size_t node, std::optional<int> color) const{
     return _adjList0[node].size()+ _adjList1[node].size();
 }
 
-long long BiColoredGraph::BiColoredChibaNishizeki()
+size_t BiColoredGraph::memory_usage() const {
+    return Memory::of(_adjList0) + Memory::of(_adjList1);
+}
+
+c4count BiColoredGraph::BiColoredChibaNishizeki(std::vector<long long>* perNode)
 {
-    //ScopedTimer t1("BiColoredChibaNishizeki");
-    long long totalC4 = 0;
+    static const auto timerId = ScopedTimer::intern("BiColoredChibaNishizeki");
+    ScopedTimer t1(timerId);
+    c4count totalC4 = 0;
 
     //Any edge (u,v) can exist in 2 colors 0 and 1.
     //This is ChibaNishizeki, but counting two types of wedges: 0-1-wedges and 1-0-wedges.
@@ -100,6 +112,10 @@ long long BiColoredGraph::BiColoredChibaNishizeki()
         });
     }
 
+    if (perNode) {
+        perNode->assign(n_max(), 0);
+    }
+
     std::vector<std::vector<int>> adjList0Copy = _adjList0;
     std::vector<std::vector<int>> adjList1Copy = _adjList1;
 
@@ -111,7 +127,13 @@ long long BiColoredGraph::BiColoredChibaNishizeki()
     wedges10.set_empty_key(-1);
 #endif
 
+    // Scratch memory: the copies only shrink, the wedge maps peak at some node u
+    const size_t copyBytes = Memory::of(nodes) + Memory::of(adjList0Copy) + Memory::of(adjList1Copy) + (perNode ? Memory::of(*perNode) : 0);
+    size_t peakWedgeBytes = 0;
+
     for (int u : nodes) {
+        long long squaresOfU = 0;
+        size_t wedgeEntries = 0;
         wedges01.clear();
         wedges10.clear();
         for (int v : adjList0Copy[u]) {
@@ -121,7 +143,7 @@ long long BiColoredGraph::BiColoredChibaNishizeki()
                     continue;
                 }
                 int w = *it;
-                wedges01[w].emplace(v);
+                wedgeEntries += wedges01[w].emplace(v).second;
                 ++it;
             }
             adjList0Copy[v].erase(std::remove(adjList0Copy[v].begin(), adjList0Copy[v].end(), u), adjList0Copy[v].end());
@@ -133,11 +155,14 @@ long long BiColoredGraph::BiColoredChibaNishizeki()
                     continue;
                 }
                 int w = *it;
-                wedges10[w].emplace(v);
+                wedgeEntries += wedges10[w].emplace(v).second;
                 ++it;
             }
             adjList1Copy[v].erase(std::remove(adjList1Copy[v].begin(), adjList1Copy[v].end(), u), adjList1Copy[v].end());
         }
+        const size_t wedgeKeys = wedges01.size() + wedges10.size();
+        peakWedgeBytes = std::max(peakWedgeBytes, wedgeKeys * (sizeof(mapIntSet::value_type) + Memory::HashNodeOverhead + sizeof(void*))
+                                                  + wedgeEntries * (sizeof(node) + Memory::TreeNodeOverhead));
 
         for (auto& [w, nodes01] : wedges01) {
             std::set<node> & nodes10 = wedges10[w];
@@ -149,9 +174,24 @@ long long BiColoredGraph::BiColoredChibaNishizeki()
             );
 
             //This is the number of bicolored squares. Each square can have 2 bicolorings.
-            totalC4 += 1LL * nodes01.size()*nodes10.size() - intersection.size();
+            long long squares = 1LL * nodes01.size()*nodes10.size() - intersection.size();
+            squaresOfU += squares;
+
+            if (perNode and squares > 0) {
+                //u and w are in all of them, a middle node pairs with every middle node of the other wedge type except itself
+                (*perNode)[u] += squares;
+                (*perNode)[w] += squares;
+                for (node v : nodes01) {
+                    (*perNode)[v] += nodes10.size() - nodes10.count(v);
+                }
+                for (node v : nodes10) {
+                    (*perNode)[v] += nodes01.size() - nodes01.count(v);
+                }
+            }
         }  
+        totalC4 += squaresOfU;
     }
+    _scratchBytes = copyBytes + peakWedgeBytes;
 
    return totalC4;
 
@@ -0,0 +1,65 @@
+#include "eis.hpp"
+#include <stdexcept>
+
+Estimator::Algorithm Estimator::parse(const std::string& name)
+{
+    for (Algorithm algorithm : all()) {
+        if (name == Estimator::name(algorithm)) return algorithm;
+    }
+    throw std::invalid_argument("Unknown algorithm: " + name);
+}
+
+std::string Estimator::name(Algorithm algorithm)
+{
+    switch (algorithm) {
+    case Algorithm::EIS: return "EIS";
+    case Algorithm::EISm: return "EISm";
+    case Algorithm::NIS: return "NIS";
+    case Algorithm::ThreeES: return "3ES";
+    case Algorithm::Exact: return "exact";
+    }
+    return "";
+}
+
+std::vector<Estimator::Algorithm> Estimator::all()
+{
+    return {Algorithm::EIS, Algorithm::EISm, Algorithm::NIS, Algorithm::ThreeES, Algorithm::Exact};
+}
+
+EstimatorResult Estimator::run(const Graph& graph, Algorithm algorithm, int k, int s)
+{
+    if (algorithm != Algorithm::Exact and k <= 0) throw std::invalid_argument("invalid k");
+    switch (algorithm) {
+    case Algorithm::EIS:
+        return graph.EIS(k, 1);
+    case Algorithm::EISm:
+        if (s <= 0 or s > k) throw std::invalid_argument("invalid s");
+        return graph.EIS(k, s);
+    case Algorithm::NIS:
+        return graph.NIS(k);
+    case Algorithm::ThreeES:
+        return graph.multipass_baseline(k);
+    case Algorithm::Exact:
+        return EstimatorResult::exactCount(graph.countFourCycles().total);
+    }
+    throw std::invalid_argument("Unknown algorithm");
+}
+
+std::unique_ptr<EstimatorConsumer> Estimator::consumer(Algorithm algorithm, int k, int s)
+{
+    if (k <= 0) throw std::invalid_argument("invalid k");
+    switch (algorithm) {
+    case Algorithm::EIS:
+        return std::make_unique<EISConsumer>(k, 1);
+    case Algorithm::EISm:
+        if (s <= 0 or s > k) throw std::invalid_argument("invalid s");
+        return std::make_unique<EISConsumer>(k, s);
+    case Algorithm::NIS:
+        return std::make_unique<NISConsumer>(k);
+    case Algorithm::ThreeES:
+        return std::make_unique<ThreeESConsumer>(k);
+    case Algorithm::Exact:
+        break;
+    }
+    throw std::invalid_argument(name(algorithm) + " cannot be fused with other estimators");
+}
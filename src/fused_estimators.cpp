@@ -0,0 +1,418 @@
+#include "fused_estimators.hpp"
+#include "basics/memory.hpp"
+#include "basics/random.hpp"
+#include "basics/report.hpp"
+#include "basics/serialize.hpp"
+#include "basics/timer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+std::span<const Graph::edge> EdgeListStream::nextBlock()
+{
+    const size_t begin = _position;
+    _position = std::min(_edges.size(), _position + BlockSize);
+    return {_edges.data() + begin, _position - begin};
+}
+
+BinaryFileStream::BinaryFileStream(const std::string& filename) : _in(filename, std::ios::binary)
+{
+    if (!_in.is_open()) {
+        throw std::runtime_error("Could not open file: " + filename);
+    }
+    Graph::readBinaryHeader(_in, _n, _m);
+    _edgesBegin = _in.tellg();
+    _buffer.resize(2 * BlockSize);
+    _block.reserve(BlockSize);
+}
+
+void BinaryFileStream::rewind()
+{
+    _in.clear();
+    _in.seekg(_edgesBegin);
+    _read = 0;
+}
+
+std::span<const Graph::edge> BinaryFileStream::nextBlock()
+{
+    _block.clear();
+    while (_block.empty() and _read < _m) {
+        const long long count = std::min<long long>(_m - _read, BlockSize);
+        _in.read(reinterpret_cast<char*>(_buffer.data()), count * 2 * sizeof(uint32_t));
+        if (!_in) {
+            throw std::runtime_error("Number of edges mismatch.");
+        }
+        for (long long i = 0; i < count; ++i) {
+            if (_buffer[2 * i] != _buffer[2 * i + 1]) _block.emplace_back(_buffer[2 * i], _buffer[2 * i + 1]);
+        }
+        _read += count;
+    }
+    return _block;
+}
+
+
+EISConsumer::EISConsumer(int k, int s, std::unordered_map<Graph::node, double>* localEstimates)
+    : _k(k), _samples(s), _localEstimates(localEstimates) {}
+
+// The samples are independent and each draws from its own generator, so they are processed in
+// parallel with the same results. schedule(static) hands every sample to the same thread in all
+// loops: its reservoir and graph are first touched by that thread and stay on its NUMA node.
+void EISConsumer::begin(long long m)
+{
+    const int reservoirsize = std::min<long long>(_k / _samples.size(), m);
+    #pragma omp parallel for schedule(static) if(_samples.size() > 1)
+    for (size_t i = 0; i < _samples.size(); ++i) {
+        _samples[i].setupReservoirSampling(reservoirsize);
+    }
+}
+
+void EISConsumer::firstPass(std::span<const Graph::edge> block)
+{
+    #pragma omp parallel for schedule(static) if(_samples.size() > 1)
+    for (size_t i = 0; i < _samples.size(); ++i) {
+        for (const auto& edge : block) {
+            _samples[i].processForReservoirSampling(edge);
+        }
+    }
+}
+
+void EISConsumer::endFirstPass()
+{
+    #pragma omp parallel for schedule(static) if(_samples.size() > 1)
+    for (size_t i = 0; i < _samples.size(); ++i) {
+        _samples[i].finalizeReservoirSampling();
+    }
+}
+
+void EISConsumer::secondPass(std::span<const Graph::edge> block)
+{
+    #pragma omp parallel for schedule(static) if(_samples.size() > 1)
+    for (size_t i = 0; i < _samples.size(); ++i) {
+        for (const auto& edge : block) {
+            _samples[i].collectInducedEge(edge);
+        }
+    }
+}
+
+EstimatorResult EISConsumer::estimate()
+{
+    return combine(_samples, _localEstimates);
+}
+
+void EISConsumer::merge(const EISConsumer& other)
+{
+    if (_k != other._k or _samples.size() != other._samples.size()) {
+        throw std::invalid_argument("Cannot merge EIS samples of different k or s.");
+    }
+    for (size_t i = 0; i < _samples.size(); ++i) {
+        _samples[i].merge(other._samples[i]);
+    }
+}
+
+void EISConsumer::write(std::ostream& out) const
+{
+    Binary::write<int>(out, _k);
+    Binary::write<int>(out, _samples.size());
+    for (const auto& sample : _samples) {
+        sample.write(out);
+    }
+}
+
+void EISConsumer::read(std::istream& in)
+{
+    _k = Binary::read<int>(in);
+    _samples = std::vector<Sample>(Binary::read<int>(in));
+    for (auto& sample : _samples) {
+        sample.read(in);
+    }
+}
+
+EstimatorResult EISConsumer::combine(std::vector<Sample>& samples, std::unordered_map<Graph::node, double>* localEstimates)
+{
+    // All s samples are alive at the same time
+    size_t sampleBytes = 0;
+    for (const auto& sample : samples) {
+        sampleBytes += sample.memory_usage();
+    }
+    MemoryTracker::record("EIS::samples", sampleBytes);
+    std::vector<long double> estimates;
+    std::unordered_map<Graph::node, double> sampleLocalEstimates;
+    if (localEstimates) {
+        localEstimates->clear();
+        for (auto& sample : samples) {
+            // nodes missing from a sample contribute an estimate of 0
+            sampleLocalEstimates.clear();
+            estimates.push_back(sample.estimate(&sampleLocalEstimates).value());
+            for (const auto& [u, estimate] : sampleLocalEstimates) {
+                (*localEstimates)[u] += estimate / samples.size();
+            }
+        }
+    } else {
+        // Same assignment of samples to threads as in the passes
+        estimates.resize(samples.size());
+        #pragma omp parallel for schedule(static) if(samples.size() > 1)
+        for (size_t i = 0; i < samples.size(); ++i) {
+            estimates[i] = samples[i].estimate().value();
+        }
+    }
+    for (const auto& sample : samples) {
+        RunReport::addSample(sample.stats());
+    }
+
+    long double sum = 0;
+    for (long double estimate : estimates) {
+        sum += estimate;
+    }
+    const long double mean = sum / estimates.size();
+    return EstimatorResult(mean, std::move(estimates));
+}
+
+
+void NISConsumer::firstPass(std::span<const Graph::edge> block)
+{
+    for (const auto& edge : block) {
+        insert(edge);
+    }
+}
+
+void NISConsumer::insert(const Graph::edge& edge)
+{
+    _m++;
+    auto [u, v] = edge;
+    uint32_t score = std::max(_tabHash.Simple(u), _tabHash.Simple(v));
+
+    if (score > _threshold)
+        return;
+
+    _bst.insert({score, edge});
+    shrink();
+}
+
+void NISConsumer::shrink()
+{
+    // If the BST exceeds size k, remove the edges with largest score
+    while (_bst.size() > _k) {
+        auto max_score = _bst.rbegin()->first;
+
+        // Remove all elements with the same max score
+        auto it = _bst.lower_bound({max_score, {0, 0}});
+        while (it != _bst.end()) {
+            it = _bst.erase(it);
+        }
+        _threshold = max_score - 1;
+    }
+}
+
+void NISConsumer::merge(const NISConsumer& other)
+{
+    if (_k != other._k) throw std::invalid_argument("Cannot merge NIS samples of different k.");
+    if (not _hashSeed or _hashSeed != other._hashSeed) {
+        throw std::invalid_argument("Cannot merge NIS samples without the same hash seed.");
+    }
+    _threshold = std::min(_threshold, other._threshold);
+    if (_threshold < std::numeric_limits<uint32_t>::max()) {
+        _bst.erase(_bst.lower_bound({_threshold + 1, {0, 0}}), _bst.end());
+    }
+    for (const auto& entry : other._bst) {
+        if (entry.first > _threshold) break;
+        _bst.insert(entry);
+    }
+    _m += other._m;
+    shrink();
+}
+
+void NISConsumer::write(std::ostream& out) const
+{
+    if (not _hashSeed) throw std::logic_error("NIS sample without a hash seed cannot be merged later.");
+    Binary::write<int>(out, _k);
+    Binary::write<uint64_t>(out, *_hashSeed);
+    Binary::write<uint32_t>(out, _threshold);
+    Binary::write<long long>(out, _m);
+    std::vector<Graph::edge> edges;
+    edges.reserve(_bst.size());
+    for (const auto& [score, edge] : _bst) {
+        edges.push_back(edge);
+    }
+    Binary::write(out, edges);
+}
+
+void NISConsumer::read(std::istream& in)
+{
+    _k = Binary::read<int>(in);
+    _hashSeed = Binary::read<uint64_t>(in);
+    _tabHash.Reset(*_hashSeed);
+    _threshold = Binary::read<uint32_t>(in);
+    _m = Binary::read<long long>(in);
+    // The scores follow from the hash function
+    _bst.clear();
+    for (const auto& [u, v] : Binary::readEdges(in)) {
+        _bst.insert({std::max(_tabHash.Simple(u), _tabHash.Simple(v)), {u, v}});
+    }
+}
+
+void NISConsumer::erase(const Graph::edge& edge)
+{
+    _m--;
+    auto [u, v] = edge;
+    uint32_t score = std::max(_tabHash.Simple(u), _tabHash.Simple(v));
+    if (score <= _threshold) {
+        _bst.erase({score, edge});
+    }
+}
+
+EstimatorResult NISConsumer::estimate()
+{
+    Graph sampleGraph;
+    std::unordered_map<int, int> sampleNodesReMapping;
+    Graph::node nextNode = 0;
+
+    auto getMappedNode = [&](Graph::node original) -> Graph::node {
+        auto [it, inserted] = sampleNodesReMapping.try_emplace(original, nextNode);
+        if (inserted) nextNode++;
+        return it->second;
+    };
+
+    int collectedEdges = 0;
+    for (const auto& [score, edge] : _bst) {
+        auto [u, v] = edge;
+        int mappedU = getMappedNode(u);
+        int mappedV = getMappedNode(v);
+        sampleGraph.addEdge(mappedU, mappedV, true);
+        collectedEdges++;
+    }
+
+    MemoryTracker::record("NIS::sample", Memory::of(_bst) + Memory::of(sampleNodesReMapping) + sampleGraph.memory_usage());
+    c4count sampleCount = sampleGraph.ChibaNishizeki();
+    RunReport::addSample({collectedEdges, 0, 0, 0});
+
+    double prob = _m > 0 ? std::sqrt(1.0 * collectedEdges / _m) : 0;
+
+    Estimate estimate = prob > 0 ? static_cast<long double>(sampleCount)/prob/prob/prob/prob : 0;
+    return estimate;
+}
+
+
+ThreeESConsumer::ThreeESConsumer(int k) : _k(k), _gen(Seeds::next()) {}
+
+void ThreeESConsumer::begin(long long m)
+{
+    _reservoir.resize(std::min<long long>(_k, m));
+}
+
+void ThreeESConsumer::firstPass(std::span<const Graph::edge> block)
+{
+    const int reservoirsize = _reservoir.size();
+    _m += block.size();
+    for (const auto& edge : block) {
+        if (_processedEdges < reservoirsize) {
+            _reservoir[_processedEdges] = edge;
+            _processedEdges++;
+            if (_processedEdges == reservoirsize) {
+                std::shuffle(_reservoir.begin(), _reservoir.end(), _gen);
+            }
+            continue;
+        }
+        std::uniform_int_distribution<int> dist(0, _processedEdges);
+        int index = dist(_gen);
+        if (index < reservoirsize) {
+            _reservoir[index] = edge;
+        }
+        _processedEdges++;
+    }
+}
+
+void ThreeESConsumer::endFirstPass()
+{
+    // the stream may have been shorter than announced
+    _reservoir.resize(std::min<size_t>(_reservoir.size(), _processedEdges));
+    Graph::node nextNode = 0;
+    for (const auto& [u, v] : _reservoir) {
+        auto [itU, insertedU] = _sampleNodes.try_emplace(u, nextNode);
+        if (insertedU) nextNode++;
+        auto [itV, insertedV] = _sampleNodes.try_emplace(v, nextNode);
+        if (insertedV) nextNode++;
+        _sampleGraph.addEdge(itU->second, itV->second, true);
+    }
+}
+
+void ThreeESConsumer::secondPass(std::span<const Graph::edge> block)
+{
+    for (const auto& [u, v] : block) {
+        auto itU = _sampleNodes.find(u);
+        if (itU == _sampleNodes.end()) continue; // not induced
+        auto itV = _sampleNodes.find(v);
+        if (itV == _sampleNodes.end()) continue;
+        _sampleCount += _sampleGraph.countSquaresCompletedByEdge(itU->second, itV->second);
+    }
+}
+
+EstimatorResult ThreeESConsumer::estimate()
+{
+    MemoryTracker::record("multipass_baseline::sample", Memory::of(_reservoir) + Memory::of(_sampleNodes) + _sampleGraph.memory_usage());
+    RunReport::addSample({_sampleGraph.m(), 0, 0, 0});
+    double prob = _m > 0 ? 1.0 * _sampleGraph.m() / _m : 0;
+
+    Estimate estimate = prob > 0 ? static_cast<long double>(_sampleCount)/prob/prob/prob/4 : 0;
+    return estimate;
+}
+
+
+size_t FusedEstimators::add(std::unique_ptr<EstimatorConsumer> consumer)
+{
+    _consumers.push_back(std::move(consumer));
+    return _consumers.size() - 1;
+}
+
+std::vector<EstimatorResult> FusedEstimators::run(EdgeStream& stream)
+{
+    scan(stream);
+    std::vector<EstimatorResult> results;
+    for (size_t i = 0; i < _consumers.size(); ++i) {
+        results.push_back(estimate(i));
+    }
+    _consumers.clear();
+    return results;
+}
+
+void FusedEstimators::scan(EdgeStream& stream)
+{
+    static const auto fusedFirstPassTimer = ScopedTimer::intern("FusedEstimators::1st-pass");
+    static const auto fusedSecondPassTimer = ScopedTimer::intern("FusedEstimators::2nd-pass");
+    const bool single = _consumers.size() == 1;
+    const std::string prefix = single ? _consumers[0]->name() : "";
+    std::vector<EstimatorConsumer*> secondPass;
+    {
+        ScopedTimer t(single ? ScopedTimer::intern(prefix + "::1st-pass") : fusedFirstPassTimer);
+        for (auto& consumer : _consumers) {
+            consumer->begin(stream.size());
+        }
+        stream.rewind();
+        for (auto block = stream.nextBlock(); not block.empty(); block = stream.nextBlock()) {
+            for (auto& consumer : _consumers) {
+                consumer->firstPass(block);
+            }
+        }
+        for (auto& consumer : _consumers) {
+            consumer->endFirstPass();
+            if (consumer->needsSecondPass()) secondPass.push_back(consumer.get());
+        }
+    }
+
+    if (not secondPass.empty()) {
+        ScopedTimer t(single ? ScopedTimer::intern(prefix + "::2nd-pass") : fusedSecondPassTimer);
+        stream.rewind();
+        for (auto block = stream.nextBlock(); not block.empty(); block = stream.nextBlock()) {
+            for (auto* consumer : secondPass) {
+                consumer->secondPass(block);
+            }
+        }
+    }
+}
+
+EstimatorResult FusedEstimators::estimate(size_t i)
+{
+    if (i >= _consumers.size() or not _consumers[i]) throw std::out_of_range("No such estimator.");
+    EstimatorResult result = _consumers[i]->estimate();
+    _consumers[i].reset();
+    return result;
+}
@@ -0,0 +1,252 @@
+#include "generators.hpp"
+#include "basics/memory.hpp"
+#include "basics/timer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+
+static uint64_t blockSeed(uint64_t seed, long long block)
+{
+    // splitmix64, decorrelates the seeds of neighboring blocks
+    uint64_t z = seed + (block + 1) * 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+GraphGenerator::GraphGenerator(const Config& config) : _config(config)
+{
+    if (_config.n <= 0 or _config.m < 0) {
+        throw std::invalid_argument("Generator needs n > 0 and m >= 0.");
+    }
+    if (_config.model == Model::Bipartite and _config.nRight <= 0) {
+        throw std::invalid_argument("Bipartite generator needs nodes on both sides.");
+    }
+    if (_config.model != Model::Bipartite and _config.n < 2 and _config.m > 0) {
+        throw std::invalid_argument("Loop-free graphs with edges need at least two nodes.");
+    }
+    if (_config.model == Model::ChungLu and _config.exponent <= 1) {
+        throw std::invalid_argument("Chung-Lu exponent must be larger than 1.");
+    }
+    if (_config.model == Model::RMAT) {
+        if (_config.a < 0 or _config.b < 0 or _config.c < 0 or _config.a + _config.b + _config.c > 1) {
+            throw std::invalid_argument("R-MAT probabilities must be non-negative and sum to at most 1.");
+        }
+        if (_config.b + _config.c <= 0) {
+            // u and v would always take the same quadrant bits, i.e. every edge would be a loop
+            throw std::invalid_argument("R-MAT needs b + c > 0.");
+        }
+        while ((1LL << _scale) < _config.n) _scale++;
+        _config.n = 1LL << _scale;
+    }
+    if (not _config.multigraph) {
+        const long double pairs = _config.model == Model::Bipartite ? static_cast<long double>(_config.n) * _config.nRight
+                                                                     : static_cast<long double>(_config.n) * (_config.n - 1) / 2;
+        if (_config.m > pairs) throw std::invalid_argument("More edges than node pairs, a simple graph is impossible.");
+    }
+    if (n() > std::numeric_limits<Graph::node>::max()) {
+        throw std::invalid_argument("Too many nodes for the node type.");
+    }
+}
+
+long long GraphGenerator::n() const
+{
+    return _config.model == Model::Bipartite ? _config.n + _config.nRight : _config.n;
+}
+
+Graph::edge GraphGenerator::draw(std::mt19937_64& gen) const
+{
+    switch (_config.model) {
+    case Model::ErdosRenyi: {
+        std::uniform_int_distribution<long long> node(0, _config.n - 1);
+        return {node(gen), node(gen)};
+    }
+    case Model::ChungLu: {
+        // Expected degree of node i is proportional to (i+1)^(-alpha). Endpoints are drawn by
+        // inverting the continuous approximation of the weight distribution, in O(1) space.
+        const double alpha = 1.0 / (_config.exponent - 1);
+        const double upper = _config.n + 1.0;
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        auto endpoint = [&]() -> long long {
+            double x = unit(gen);
+            double i = alpha == 1.0 ? std::pow(upper, x)
+                                    : std::pow(1.0 + x * (std::pow(upper, 1 - alpha) - 1.0), 1.0 / (1 - alpha));
+            return std::min<long long>(_config.n - 1, static_cast<long long>(i) - 1);
+        };
+        const long long u = endpoint();
+        return {u, endpoint()};
+    }
+    case Model::RMAT: {
+        // Recursive quadrant choice per bit, then scatter the ids with an odd multiplier
+        // (a bijection modulo 2^scale) so that hubs are not clustered at small ids.
+        // Quadrants are chosen with 16 bit resolution, four levels per 64 bit random number.
+        const uint64_t a = _config.a * 65536, ab = (_config.a + _config.b) * 65536, abc = (_config.a + _config.b + _config.c) * 65536;
+        const uint64_t mask = _config.n - 1;
+        const uint64_t multiplier = blockSeed(_config.seed, -1) | 1;
+        uint64_t u = 0, v = 0;
+        uint64_t bits = 0;
+        for (int level = 0; level < _scale; ++level) {
+            if (level % 4 == 0) bits = gen();
+            uint64_t r = bits & 0xffff;
+            bits >>= 16;
+            u <<= 1;
+            v <<= 1;
+            if (r >= ab) u |= 1;
+            if ((r >= a and r < ab) or r >= abc) v |= 1;
+        }
+        return {(u * multiplier) & mask, (v * multiplier) & mask};
+    }
+    case Model::Bipartite: {
+        std::uniform_int_distribution<long long> left(0, _config.n - 1);
+        std::uniform_int_distribution<long long> right(0, _config.nRight - 1);
+        const long long u = left(gen);
+        return {u, _config.n + right(gen)};
+    }
+    }
+    return {0, 0};
+}
+
+void GraphGenerator::generateBlock(long long block, std::vector<Graph::edge>& edges) const
+{
+    const long long count = std::min(BlockSize, _config.m - block * BlockSize);
+    edges.clear();
+    edges.reserve(count);
+    std::mt19937_64 gen(blockSeed(_config.seed, block));
+    while (static_cast<long long>(edges.size()) < count) {
+        Graph::edge e = draw(gen);
+        if (e.first != e.second) edges.push_back(e);
+    }
+}
+
+static uint64_t edgeKey(Graph::edge e)
+{
+    const uint64_t u = std::min(e.first, e.second), v = std::max(e.first, e.second);
+    return u << 32 | v;
+}
+
+void GraphGenerator::removeRepeated(long long block, Graph::edge* edges, size_t count, std::unordered_set<uint64_t>& seen) const
+{
+    // Replacements come from a generator of their own, so that they only depend on the seed
+    std::mt19937_64 gen(blockSeed(_config.seed ^ 0x5bd1e9955bd1e995ULL, block));
+    const long long maxRedraws = RedrawsPerEdge * count + (1 << 20);
+    long long redraws = 0;
+    for (size_t i = 0; i < count; ++i) {
+        while (not seen.insert(edgeKey(edges[i])).second) {
+            do {
+                if (++redraws > maxRedraws) {
+                    throw std::runtime_error("Too many repeated edges after " + std::to_string(seen.size())
+                                             + " edges, the model is too concentrated for m edges. "
+                                             "Use fewer edges or allow parallel edges (multigraph).");
+                }
+                edges[i] = draw(gen);
+            } while (edges[i].first == edges[i].second);
+        }
+    }
+}
+
+std::vector<Graph::edge> GraphGenerator::generate() const
+{
+    static const auto timerId = ScopedTimer::intern("GraphGenerator::generate");
+    ScopedTimer t(timerId);
+    const long long blocks = (_config.m + BlockSize - 1) / BlockSize;
+    std::vector<Graph::edge> edges(_config.m);
+
+    #pragma omp parallel
+    {
+        std::vector<Graph::edge> buffer;
+        #pragma omp for schedule(dynamic)
+        for (long long block = 0; block < blocks; ++block) {
+            generateBlock(block, buffer);
+            std::copy(buffer.begin(), buffer.end(), edges.begin() + block * BlockSize);
+        }
+    }
+    if (not _config.multigraph) {
+        std::unordered_set<uint64_t> seen;
+        seen.reserve(_config.m);
+        for (long long block = 0; block < blocks; ++block) {
+            const long long first = block * BlockSize;
+            removeRepeated(block, edges.data() + first, std::min(BlockSize, _config.m - first), seen);
+        }
+        MemoryTracker::record("GraphGenerator::seen", Memory::of(seen));
+    }
+    return edges;
+}
+
+void GraphGenerator::write(const std::string& filename, Format format) const
+{
+    static const auto timerId = ScopedTimer::intern("GraphGenerator::write");
+    ScopedTimer t(timerId);
+
+    std::ofstream out(filename, std::ios::binary);
+    if (!out.is_open()) {
+        throw std::runtime_error("Could not open file: " + filename);
+    }
+
+    const bool bipartite = _config.model == Model::Bipartite;
+    if (format == Format::Konect) {
+        out << "% " << (bipartite ? "bip" : "sym") << " unweighted\n";
+        if (bipartite) {
+            out << "% " << _config.m << " " << _config.n << " " << _config.nRight << "\n";
+        } else {
+            out << "% " << _config.m << " " << _config.n << " " << _config.n << "\n";
+        }
+    } else {
+        Graph::writeBinaryHeader(out, n(), _config.m);
+    }
+
+    // Blocks are generated and formatted in parallel, one wave at a time, and written in order.
+    // Repeated edges are replaced in between, block by block.
+    const long long blocks = (_config.m + BlockSize - 1) / BlockSize;
+    const long long wave = 64;
+    std::vector<std::vector<Graph::edge>> buffers(wave);
+    std::vector<std::string> chunks(wave);
+    std::unordered_set<uint64_t> seen;
+    if (not _config.multigraph) seen.reserve(_config.m);
+    for (long long first = 0; first < blocks; first += wave) {
+        const long long last = std::min(blocks, first + wave);
+        #pragma omp parallel for schedule(dynamic)
+        for (long long block = first; block < last; ++block) {
+            generateBlock(block, buffers[block - first]);
+        }
+        if (not _config.multigraph) {
+            for (long long block = first; block < last; ++block) {
+                auto& buffer = buffers[block - first];
+                removeRepeated(block, buffer.data(), buffer.size(), seen);
+            }
+        }
+        #pragma omp parallel for schedule(dynamic)
+        for (long long block = first; block < last; ++block) {
+            const std::vector<Graph::edge>& buffer = buffers[block - first];
+            std::string& chunk = chunks[block - first];
+            chunk.clear();
+            if (format == Format::Konect) {
+                // KONECT is 1-based, the right side of bipartite graphs is numbered separately
+                char line[48];
+                for (auto [u, v] : buffer) {
+                    long long right = bipartite ? v - _config.n : v;
+                    int len = std::snprintf(line, sizeof(line), "%lld %lld\n", static_cast<long long>(u) + 1, right + 1);
+                    chunk.append(line, len);
+                }
+            } else {
+                chunk.resize(buffer.size() * 2 * sizeof(uint32_t));
+                char* p = chunk.data();
+                for (auto [u, v] : buffer) {
+                    uint32_t pair[2] = {static_cast<uint32_t>(u), static_cast<uint32_t>(v)};
+                    std::memcpy(p, pair, sizeof(pair));
+                    p += sizeof(pair);
+                }
+            }
+        }
+        for (long long block = first; block < last; ++block) {
+            out.write(chunks[block - first].data(), chunks[block - first].size());
+        }
+    }
+    MemoryTracker::record("GraphGenerator::seen", Memory::of(seen));
+}
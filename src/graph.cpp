@@ -2,16 +2,24 @@
 #include "bicoloredGraph.hpp"
 #include "tabulation_hashing.hpp"
 #include "EIS_sample.hpp"
+#include "fused_estimators.hpp"
 #include "basics/timer.hpp"
 #include "basics/parms.hpp"
+#include "basics/random.hpp"
+#include "basics/report.hpp"
+#include "basics/memory.hpp"
+#include "basics/numa.hpp"
 #include <fstream>
 #include <sstream>
 #include <stdexcept>
 #include <algorithm>
+#include <numeric>
 #include <cmath>
 #include <set>
 #include <queue>
 #include <random>
+#include <atomic>
+#include <limits>
 #include <iostream>
 
 
@@ -26,26 +34,35 @@ void Graph::addEdge(node u, node v, bool incremental)
     if (u == v) {
         return;
     }
+    if (_fourCycles) {
+        // the adjacency lists are no longer sorted, nor the edges unique
+        _fourCycles.reset();
+        _edgeIndex.clear();
+    }
     _adjList[u].push_back(v);
     _adjList[v].push_back(u);
     _edgeList.emplace_back(u, v);
 }
 
 void Graph::read_konect(const std::string& filename) {
-    // Reads a graph from a KONECT format file
-    // Removes loops. Makes graph undirected.
-    // Does not check for duplicate edges
-    // Can handle bip, sym and asym formats
-
     std::ifstream infile(filename);
     if (!infile.is_open()) {
         throw std::runtime_error("Could not open file: " + filename);
     }
+    read_konect(infile);
+}
+
+void Graph::read_konect(std::istream& infile) {
+    // Reads a graph in KONECT format
+    // Removes loops. Makes graph undirected.
+    // Does not check for duplicate edges
+    // Can handle bip, sym and asym formats
 
     std::string line;
     bool is_bipartite = false;
     int n = -1, n_left = -1, n_right = -1, m = -1;
     int maxNode = -1;
+    bool hasTimestamps = false;
     std::vector<std::pair<int, int>> edges;
 
     while (std::getline(infile, line)) {
@@ -73,6 +90,15 @@ void Graph::read_konect(const std::string& filename) {
         std::istringstream iss(line);
         int u, v;
         if (!(iss >> u >> v)) continue;
+        // Optional weight and timestamp columns; the timestamps are kept if the first edge has one
+        double weight;
+        long long timestamp;
+        const bool timed = static_cast<bool>(iss >> weight >> timestamp);
+        if (_edgeList.empty() and _timestamps.empty()) {
+            hasTimestamps = timed;
+        } else if (timed != hasTimestamps) {
+            throw std::runtime_error("Timestamps missing on some edges.");
+        }
 
         u -= 1; // Convert to 0-based index
         v -= 1;
@@ -85,20 +111,102 @@ void Graph::read_konect(const std::string& filename) {
         }
 
         maxNode = std::max({maxNode, u, v});
+        if (hasTimestamps and u != v) _timestamps.push_back(timestamp);
         addEdge(u, v);
     }
 
-    infile.close();
-
     if (_edgeList.size()!=m)
         throw std::runtime_error("Number of edges mismatch.");
+    _nLeft = is_bipartite ? n_left : 0;
+
+    finalizeAdjacency();
+    //std::cout << "Finished IO.  n "<< n << "\tm "<< m <<std::endl;
+}
+
+void Graph::read_binary(const std::string& filename) {
+    std::ifstream infile(filename, std::ios::binary);
+    if (!infile.is_open()) {
+        throw std::runtime_error("Could not open file: " + filename);
+    }
+    read_binary(infile);
+}
+
+void Graph::read_binary(std::istream& infile) {
+    long long n = 0, m = 0;
+    readBinaryHeader(infile, n, m);
+
+    _adjList.resize(n);
+    _edgeList.reserve(m);
+    std::vector<uint32_t> buffer(2 * (1 << 20));
+    long long read = 0;
+    while (read < m) {
+        long long count = std::min<long long>(m - read, buffer.size() / 2);
+        infile.read(reinterpret_cast<char*>(buffer.data()), count * 2 * sizeof(uint32_t));
+        if (!infile) {
+            throw std::runtime_error("Number of edges mismatch.");
+        }
+        for (long long i = 0; i < count; ++i) {
+            addEdge(buffer[2 * i], buffer[2 * i + 1]);
+        }
+        read += count;
+    }
+
+    finalizeAdjacency();
+}
+
+void Graph::read(const std::string& filename) {
+    if (filename == "-") {
+        read(std::cin);
+        return;
+    }
+    std::ifstream infile(filename, std::ios::binary);
+    if (!infile.is_open()) {
+        throw std::runtime_error("Could not open file: " + filename);
+    }
+    read(infile);
+}
+
+void Graph::read(std::istream& in) {
+    // KONECT files start with a comment or an edge, so the first byte tells the formats apart
+    // without having to rewind the stream
+    if (in.peek() == BinaryMagic[0]) {
+        read_binary(in);
+    } else {
+        read_konect(in);
+    }
+    // Read by a single thread, but scanned by all of them later
+    Numa::interleave(_edgeList);
+    MemoryTracker::record("Graph", memory_usage());
+}
+
+void Graph::readBinaryHeader(std::istream& in, long long& n, long long& m) {
+    char magic[sizeof(BinaryMagic)];
+    uint64_t header[2] = {0, 0};
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char*>(header), sizeof(header));
+    if (!in or not std::equal(magic, magic + sizeof(magic), BinaryMagic)) {
+        throw std::runtime_error("Not a binary graph.");
+    }
+    n = header[0];
+    m = header[1];
+}
 
+void Graph::writeBinaryHeader(std::ostream& out, long long n, long long m) {
+    uint64_t header[2] = {static_cast<uint64_t>(n), static_cast<uint64_t>(m)};
+    out.write(BinaryMagic, sizeof(BinaryMagic));
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+}
+
+void Graph::finalizeAdjacency() {
     for (auto& neighbors : _adjList) {
         std::sort(neighbors.begin(), neighbors.end());
         neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
         neighbors.shrink_to_fit();
     }
-    //std::cout << "Finished IO.  n "<< n << "\tm "<< m <<std::endl;
+}
+
+size_t Graph::memory_usage() const {
+    return Memory::of(_adjList) + Memory::of(_edgeList) + Memory::of(_originalId) + Memory::of(_timestamps) + Memory::of(_edgeIndex);
 }
 
 int Graph::n() const {
@@ -109,6 +217,14 @@ int Graph::m() const {
     return _edgeList.size();
 }
 
+const std::vector<long long>& Graph::timestamps() const {
+    return _timestamps;
+}
+
+const std::vector<Graph::edge>& Graph::edges() const {
+    return _edgeList;
+}
+
 size_t Graph::degree(size_t node) const {
     return _adjList[node].size();
 }
@@ -121,49 +237,323 @@ size_t Graph::maxdegree() const {
 }
 
 int Graph::computeDegeneracy() const {
-    //ScopedTimer t1("Graph::computeDegeneracy");
-    
-    std::vector<int> degree(_adjList.size());
-    std::vector<bool> removed(_adjList.size(), false);
+    static const auto timerId = ScopedTimer::intern("Graph::computeDegeneracy");
+    ScopedTimer t1(timerId);
+    return computeCoreDecomposition().degeneracy;
+}
 
-    for (size_t u = 0; u < _adjList.size(); ++u) {
+std::vector<Graph::node> Graph::degeneracyOrder() const {
+    return computeCoreDecomposition().order;
+}
+
+Graph::CoreDecomposition Graph::computeCoreDecomposition() const {
+    // Batagelj and Zaversnik: nodes are kept in an array sorted by remaining degree,
+    // bin[d] is the first position of degree d. Decrementing a degree swaps the node
+    // to the front of its bin, so every peeling step takes constant time per edge.
+    CoreDecomposition result;
+    const size_t n = _adjList.size();
+    std::vector<int>& degree = result.core;
+    std::vector<node>& vert = result.order;
+    degree.resize(n);
+    vert.resize(n);
+
+    size_t maxDegree = 0;
+    for (size_t u = 0; u < n; ++u) {
         degree[u] = _adjList[u].size();
+        maxDegree = std::max<size_t>(maxDegree, degree[u]);
     }
 
-    // Min-heap to process nodes in order of degree
-    std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int>>, std::greater<>> minHeap;
-    for (size_t u = 0; u < degree.size(); ++u) {
-        minHeap.emplace(degree[u], u);
+    std::vector<size_t> bin(maxDegree + 1, 0);
+    for (size_t u = 0; u < n; ++u) {
+        bin[degree[u]]++;
+    }
+    size_t start = 0;
+    for (size_t d = 0; d <= maxDegree; ++d) {
+        size_t num = bin[d];
+        bin[d] = start;
+        start += num;
     }
 
-    int maxMinDegree = 0;
+    std::vector<size_t> pos(n);
+    for (size_t u = 0; u < n; ++u) {
+        pos[u] = bin[degree[u]]++;
+        vert[pos[u]] = u;
+    }
+    for (size_t d = maxDegree; d > 0; --d) {
+        bin[d] = bin[d - 1];
+    }
+    bin[0] = 0;
 
     // Peeling process
-    while (!minHeap.empty()) {
-        auto [currentDegree, u] = minHeap.top();
-        minHeap.pop();
+    for (size_t i = 0; i < n; ++i) {
+        node v = vert[i];
+        for (node u : _adjList[v]) {
+            if (degree[u] > degree[v]) {
+                int du = degree[u];
+                size_t pu = pos[u];
+                size_t pw = bin[du];
+                node w = vert[pw];
+                if (u != w) {
+                    pos[u] = pw;
+                    vert[pu] = w;
+                    pos[w] = pu;
+                    vert[pw] = u;
+                }
+                bin[du]++;
+                degree[u]--;
+            }
+        }
+        result.degeneracy = std::max(result.degeneracy, degree[v]);
+    }
+
+    return result;
+}
+
+Graph::CoreDecomposition Graph::computeCoreDecompositionParallel() const {
+    // Peels level by level. Within a level, the nodes whose remaining degree reached the
+    // level are removed in synchronous sub-rounds. Ordering by (level, sub-round) is a
+    // degeneracy order: a node has at most `level` neighbors not removed before its sub-round.
+    CoreDecomposition result;
+    const node n = _adjList.size();
+    std::vector<int> degree(n);
+    result.core.assign(n, -1);
+    result.order.reserve(n);
+
+    #pragma omp parallel for
+    for (node u = 0; u < n; ++u) {
+        degree[u] = _adjList[u].size();
+    }
+
+    std::vector<node> frontier;
+    std::vector<node> next;
+    size_t removed = 0;
+    while (removed < static_cast<size_t>(n)) {
+        // Skip empty levels
+        int level = std::numeric_limits<int>::max();
+        #pragma omp parallel for reduction(min:level)
+        for (node u = 0; u < n; ++u) {
+            if (result.core[u] < 0) level = std::min(level, degree[u]);
+        }
+
+        frontier.clear();
+        #pragma omp parallel
+        {
+            std::vector<node> local;
+            #pragma omp for nowait
+            for (node u = 0; u < n; ++u) {
+                if (result.core[u] < 0 and degree[u] == level) local.push_back(u);
+            }
+            #pragma omp critical
+            frontier.insert(frontier.end(), local.begin(), local.end());
+        }
+
+        while (!frontier.empty()) {
+            for (node v : frontier) {
+                result.core[v] = level;
+            }
+            result.order.insert(result.order.end(), frontier.begin(), frontier.end());
+            removed += frontier.size();
+            result.degeneracy = std::max(result.degeneracy, level);
+
+            next.clear();
+            #pragma omp parallel
+            {
+                std::vector<node> local;
+                #pragma omp for nowait schedule(dynamic, 64)
+                for (size_t i = 0; i < frontier.size(); ++i) {
+                    for (node u : _adjList[frontier[i]]) {
+                        std::atomic_ref<int> du(degree[u]);
+                        if (du.load(std::memory_order_relaxed) <= level) continue;
+                        int old = du.fetch_sub(1, std::memory_order_relaxed);
+                        if (old == level + 1) {
+                            local.push_back(u);
+                        } else if (old <= level) {
+                            du.fetch_add(1, std::memory_order_relaxed); // lost a race, u is already in the frontier
+                        }
+                    }
+                }
+                #pragma omp critical
+                next.insert(next.end(), local.begin(), local.end());
+            }
+            frontier.swap(next);
+        }
+    }
+
+    return result;
+}
+
+std::vector<Graph::node> Graph::computeOrdering(NodeOrdering ordering) const {
+    switch (ordering) {
+    case NodeOrdering::Degree: {
+        // Same order in which ChibaNishizeki processes the nodes
+        std::vector<node> nodes(n());
+        std::iota(nodes.begin(), nodes.end(), 0);
+        std::sort(nodes.begin(), nodes.end(), [this](int a, int b) {
+            return (degree(a) > degree(b)) || (degree(a) == degree(b) && a > b);
+        });
+        return nodes;
+    }
+    case NodeOrdering::Degeneracy: {
+        // Reverse peeling order: the densest core receives the smallest ids
+        std::vector<node> nodes = degeneracyOrder();
+        std::reverse(nodes.begin(), nodes.end());
+        return nodes;
+    }
+    case NodeOrdering::RCM:
+        return rcmOrder();
+    case NodeOrdering::Gorder:
+        return gorderOrder();
+    }
+    throw std::invalid_argument("Unknown node ordering.");
+}
+
+std::vector<Graph::node> Graph::rcmOrder() const {
+    // Reverse Cuthill-McKee: BFS from a minimum degree node of every component,
+    // visiting unvisited neighbors by increasing degree.
+    std::vector<node> byDegree(n());
+    std::iota(byDegree.begin(), byDegree.end(), 0);
+    std::stable_sort(byDegree.begin(), byDegree.end(), [this](int a, int b) {
+        return degree(a) < degree(b);
+    });
+
+    std::vector<node> order;
+    order.reserve(n());
+    std::vector<bool> visited(n(), false);
+    std::vector<node> frontier;
+
+    for (node start : byDegree) {
+        if (visited[start]) continue;
+        visited[start] = true;
+        size_t head = order.size();
+        order.push_back(start);
+        while (head < order.size()) {
+            node u = order[head++];
+            frontier.clear();
+            for (node v : _adjList[u]) {
+                if (!visited[v]) {
+                    visited[v] = true;
+                    frontier.push_back(v);
+                }
+            }
+            std::stable_sort(frontier.begin(), frontier.end(), [this](int a, int b) {
+                return degree(a) < degree(b);
+            });
+            order.insert(order.end(), frontier.begin(), frontier.end());
+        }
+    }
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+std::vector<Graph::node> Graph::gorderOrder(int window) const {
+    // Greedy Gorder heuristic: next node is the unplaced node sharing the most
+    // edges and common neighbors with the last `window` placed nodes.
+    // Like Gorder, sibling scores are not propagated through hubs.
+    const size_t hubDegree = std::max<size_t>(1, std::sqrt(n()));
 
-        if (removed[u]) continue;
+    std::vector<node> byDegree = computeOrdering(NodeOrdering::Degree);
+    size_t nextByDegree = 0;
 
-        removed[u] = true;
-        maxMinDegree = std::max(maxMinDegree, currentDegree);
+    std::vector<int> score(n(), 0);
+    std::vector<bool> placed(n(), false);
+    std::priority_queue<std::pair<int, node>> maxHeap; // lazy, stale entries are skipped
+
+    auto update = [&](node v, int delta) {
+        for (node u : _adjList[v]) {
+            if (!placed[u]) {
+                score[u] += delta;
+                if (score[u] > 0) maxHeap.emplace(score[u], u);
+            }
+            if (degree(u) > hubDegree) continue;
+            for (node w : _adjList[u]) {
+                if (w == v or placed[w]) continue;
+                score[w] += delta;
+                if (score[w] > 0) maxHeap.emplace(score[w], w);
+            }
+        }
+    };
 
-        // Update degrees of neighbors
-        for (int v : _adjList[u]) {
-            if (!removed[v]) {
-                degree[v]--;
-                minHeap.emplace(degree[v], v);
+    std::vector<node> order;
+    order.reserve(n());
+    while (order.size() < static_cast<size_t>(n())) {
+        node v = -1;
+        while (!maxHeap.empty()) {
+            auto [s, u] = maxHeap.top();
+            maxHeap.pop();
+            if (!placed[u] and score[u] == s) {
+                v = u;
+                break;
             }
         }
+        if (v < 0) {
+            // Nothing adjacent to the window: continue with the largest unplaced node
+            while (placed[byDegree[nextByDegree]]) nextByDegree++;
+            v = byDegree[nextByDegree];
+        }
+        placed[v] = true;
+        order.push_back(v);
+        update(v, 1);
+        if (order.size() > static_cast<size_t>(window)) {
+            update(order[order.size() - 1 - window], -1);
+        }
+    }
+    return order;
+}
+
+void Graph::relabel(NodeOrdering ordering) {
+    static const auto timerId = ScopedTimer::intern("Graph::relabel");
+    ScopedTimer t1(timerId);
+    std::vector<node> order = computeOrdering(ordering);
+
+    std::vector<node> newId(n());
+    for (node i = 0; i < n(); ++i) {
+        newId[order[i]] = i;
+    }
+
+    // Build the new adjacency in new id order so that lists of consecutive nodes are allocated close to each other
+    std::vector<std::vector<node>> adjList(n());
+    for (node i = 0; i < n(); ++i) {
+        const auto& neighbors = _adjList[order[i]];
+        adjList[i].reserve(neighbors.size());
+        for (node v : neighbors) {
+            adjList[i].push_back(newId[v]);
+        }
+        std::sort(adjList[i].begin(), adjList[i].end());
+    }
+
+    for (auto& [u, v] : _edgeList) {
+        u = newId[u];
+        v = newId[v];
     }
 
-    return maxMinDegree;
+    std::vector<node> originalIds(n());
+    for (node i = 0; i < n(); ++i) {
+        originalIds[i] = _originalId.empty() ? order[i] : _originalId[order[i]];
+    }
+
+    _adjList = std::move(adjList);
+    _originalId = std::move(originalIds);
+    _fourCycles.reset();
+    _edgeIndex.clear();
 }
 
-long long Graph::ChibaNishizeki()
+Graph::node Graph::originalId(node u) const {
+    // nodes added after relabeling keep their id
+    return static_cast<size_t>(u) < _originalId.size() ? _originalId[u] : u;
+}
+
+std::string Graph::inputId(node u) const {
+    const node id = originalId(u);
+    if (_nLeft == 0) return std::to_string(id + 1);
+    // the right side was shifted behind the left one on reading
+    return id < _nLeft ? "L" + std::to_string(id + 1) : "R" + std::to_string(id - _nLeft + 1);
+}
+
+c4count Graph::ChibaNishizeki()
 {
-    //ScopedTimer t1("Graph::ChibaNishizeki");
-    long long totalC4 = 0;
+    static const auto timerId = ScopedTimer::intern("Graph::ChibaNishizeki");
+    ScopedTimer t1(timerId);
+    c4count totalC4 = 0;
 
     //Sort nodes by degree
     std::vector<int> nodes(n());
@@ -194,211 +584,286 @@ long long Graph::ChibaNishizeki()
             }
         }
 
+        long long squaresOfU = 0;
         for (auto it = commonneighbors.begin(); it != commonneighbors.end(); ++it) {
             const long long w = it->second;
             if (w >= 2) {
                 long long squares = (1LL *w * (w - 1)) / 2;
-                totalC4 += squares;
+                squaresOfU += squares;
             }
         }
+        totalC4 += squaresOfU;
     }
     return totalC4;
 
 }
 
-long long Graph::EIS(int k, int s) const
-{
-    std::random_device rd;
-    std::mt19937 gen(rd());
-
-
-    int reservoirsize = std::min({k/s,m()});
-
-    std::vector<Sample> samples(s);
-    
-    //std::cout << "Using "<<s<<" samples of size "<<reservoirsize<<".\n";
+// Adjacency in rank space used by countFourCycles(). Node r is the r-th node of the
+// orientation order and neighbor lists are sorted, so lower ranked neighbors form a prefix.
+struct RankedAdjacency {
+    std::vector<size_t> offsets;
+    std::vector<int> neighbors;
+    std::vector<int> edgeIds;  // undirected edge id of every slot, only built for local counts
+    int numEdges = 0;
 
-    {
-        //ScopedTimer t3("EIS::1st-pass");
-        for (auto& sample : samples) {
-            sample.setupReservoirSampling(reservoirsize);
-        }
-        for (const auto& edge : _edgeList) {
-            for (auto& sample : samples) {
-                sample.processForReservoirSampling(edge);
-            }
-        }
-        for (auto& sample : samples) {
-            sample.finalizeReservoirSampling();
-        }
+    size_t slot(int u, int v) const {
+        return std::lower_bound(neighbors.begin() + offsets[u], neighbors.begin() + offsets[u + 1], v) - neighbors.begin();
     }
+};
 
-    {
-        //ScopedTimer t3("EIS::2nd-pass");
-        //2nd Pass
-        for (const auto& edge : _edgeList) {
-            for (auto& sample : samples) {
-                sample.collectInducedEge(edge);
-            }
+// Neighbor lists of the nodes in the given order (rank -> node), in rank space and without parallel edges
+static RankedAdjacency rankedAdjacency(const std::vector<std::vector<Graph::node>>& adjList, const std::vector<Graph::node>& order, const std::vector<int>& rank)
+{
+    const int n = order.size();
+    RankedAdjacency adj;
+    adj.offsets.resize(n + 1, 0);
+    for (int r = 0; r < n; ++r) {
+        adj.offsets[r + 1] = adj.offsets[r] + adjList[order[r]].size();
+    }
+    adj.neighbors.resize(adj.offsets[n]);
+    std::vector<size_t> uniqueDegree(n);
+    #pragma omp parallel for schedule(dynamic, 256)
+    for (int r = 0; r < n; ++r) {
+        auto begin = adj.neighbors.begin() + adj.offsets[r];
+        auto end = begin;
+        for (Graph::node v : adjList[order[r]]) {
+            *end++ = rank[v];
         }
+        std::sort(begin, end);
+        uniqueDegree[r] = std::unique(begin, end) - begin; // graphs built with addEdge may contain parallel edges
     }
-    std::vector<long long> estimates;
-    for (auto& sample : samples) {
-        estimates.push_back(sample.estimate());
+    size_t compacted = 0;
+    for (int r = 0; r < n; ++r) {
+        std::copy(adj.neighbors.begin() + adj.offsets[r], adj.neighbors.begin() + adj.offsets[r] + uniqueDegree[r], adj.neighbors.begin() + compacted);
+        adj.offsets[r] = compacted;
+        compacted += uniqueDegree[r];
     }
-
-    long long mean = std::accumulate(estimates.begin(), estimates.end(), 0LL) / estimates.size();
-    return mean;
+    adj.offsets[n] = compacted;
+    adj.neighbors.resize(compacted);
+    // Wedges reach the neighbor lists of all nodes from every thread
+    Numa::interleave(adj.offsets);
+    Numa::interleave(adj.neighbors);
+    return adj;
 }
 
-
-long long Graph::NIS(int k) const
+// Counts every four-cycle u-v-w-x once at its highest ranked node u: wedges u-v-w with v,w < u
+// are accumulated in a dense per-thread array and w closes binom(c,2) cycles with u.
+// Local counts are accumulated per thread and summed up at the end.
+template <bool Local>
+static c4count countOrientedWedges(const RankedAdjacency& adj, std::vector<long long>& perNode, std::vector<long long>& perEdge)
 {
-    //ScopedTimer t1("NIS");
-    TabHash tabHash;
-
-    uint32_t max_hash_value = std::numeric_limits<uint32_t>::max();
-
-    auto hash = [&](node x) -> uint32_t {
-        return tabHash.Simple(x);
-    };
+    const int n = adj.offsets.size() - 1;
+    c4count totalC4 = 0;
+    std::vector<std::vector<long long>> nodeAcc;
+    std::vector<std::vector<long long>> edgeAcc;
+    size_t scratchBytes = Memory::of(adj.offsets) + Memory::of(adj.neighbors) + Memory::of(adj.edgeIds) + Memory::of(perNode) + Memory::of(perEdge);
 
-    Graph sampleGraph;
-    std::unordered_map<int, int> sampleNodesReMapping;
-    node nextNode = 0;
-
-    auto getMappedNode = [&](node original) -> node {
-        if (sampleNodesReMapping.find(original) == sampleNodesReMapping.end()) {
-            sampleNodesReMapping[original] = nextNode++;
+    #pragma omp parallel
+    {
+        c4count threadC4 = 0;
+        std::vector<int> wedges(n, 0);
+        std::vector<int> touched;
+        std::vector<long long> localNode;
+        std::vector<long long> localEdge;
+        if constexpr (Local) {
+            localNode.assign(n, 0);
+            localEdge.assign(adj.numEdges, 0);
         }
-        return sampleNodesReMapping[original];
-    };
-
-
-    //Store edges in a bst or heap of size k indexed by hash cutoff threshold
-    std::set<std::pair<uint32_t, std::pair<node, node>>> bst;
-    auto current_threshold = max_hash_value;
+        #pragma omp atomic
+        scratchBytes += Memory::of(wedges) + Memory::of(localNode) + Memory::of(localEdge);
+
+        #pragma omp for schedule(dynamic, 64)
+        for (int u = 0; u < n; ++u) {
+            for (size_t i = adj.offsets[u]; i < adj.offsets[u + 1]; ++i) {
+                const int v = adj.neighbors[i];
+                if (v >= u) break;
+                for (size_t j = adj.offsets[v]; j < adj.offsets[v + 1]; ++j) {
+                    const int w = adj.neighbors[j];
+                    if (w >= u) break;
+                    if (wedges[w]++ == 0) touched.push_back(w);
+                }
+            }
 
-    //1st Pass
-    for (const auto& edge : _edgeList) {
-        auto [u, v] = edge;
-        uint32_t score = std::max(hash(u),hash(v));
+            long long squaresOfU = 0;
+            for (int w : touched) {
+                const long long c = wedges[w];
+                if (c >= 2) {
+                    const long long squares = c * (c - 1) / 2;
+                    squaresOfU += squares;
+                    if constexpr (Local) {
+                        localNode[u] += squares;
+                        localNode[w] += squares;
+                    }
+                }
+            }
+            threadC4 += squaresOfU;
+
+            if constexpr (Local) {
+                // A wedge u-v-w lies on c-1 cycles, one with every other wedge to w
+                for (size_t i = adj.offsets[u]; i < adj.offsets[u + 1]; ++i) {
+                    const int v = adj.neighbors[i];
+                    if (v >= u) break;
+                    for (size_t j = adj.offsets[v]; j < adj.offsets[v + 1]; ++j) {
+                        const int w = adj.neighbors[j];
+                        if (w >= u) break;
+                        const long long others = wedges[w] - 1;
+                        localNode[v] += others;
+                        localEdge[adj.edgeIds[i]] += others;
+                        localEdge[adj.edgeIds[j]] += others;
+                    }
+                }
+            }
 
-        if (score > current_threshold) 
-            continue;
+            for (int w : touched) {
+                wedges[w] = 0;
+            }
+            touched.clear();
+        }
 
-        bst.insert({score, edge});
+        #pragma omp critical
+        {
+            totalC4 += threadC4;
+            scratchBytes += Memory::of(touched); // grown to its largest size by now
+        }
 
-        // If the BST exceeds size k, remove the edges with largest score
-        if (bst.size() > k) {
-            auto max_score = bst.rbegin()->first;
+        if constexpr (Local) {
+            #pragma omp critical
+            {
+                nodeAcc.push_back(std::move(localNode));
+                edgeAcc.push_back(std::move(localEdge));
+            }
+            #pragma omp barrier
 
-            // Find first element with max score
-            auto it = bst.lower_bound({max_score, {0, 0}}); 
-           
-            // Remove all elements with the same max score
-            while (it != bst.end()) {
-                it = bst.erase(it);
+            #pragma omp for nowait
+            for (int u = 0; u < n; ++u) {
+                for (const auto& acc : nodeAcc) perNode[u] += acc[u];
+            }
+            #pragma omp for
+            for (int e = 0; e < adj.numEdges; ++e) {
+                for (const auto& acc : edgeAcc) perEdge[e] += acc[e];
             }
-            current_threshold = max_score - 1;
         }
     }
-
-    int collectedEdges = 0;
-    for (const auto& [score, edge] : bst) {
-        auto [u, v] = edge;
-        int mappedU = getMappedNode(u);
-        int mappedV = getMappedNode(v);
-        sampleGraph.addEdge(mappedU,mappedV,true);
-        collectedEdges++;
-    }
-
-    long long sampleCount=sampleGraph.ChibaNishizeki();
-
-    double prob = std::sqrt(1.0 * collectedEdges / m());
-
-    long long estimate = std::llround(1.0*sampleCount/prob/prob/prob/prob);
-    return estimate;
+    MemoryTracker::record("countFourCycles", scratchBytes);
+    return totalC4;
 }
 
-
-long long Graph::multipass_baseline(int k) const
+Graph::FourCycleCounts Graph::countFourCycles(bool local, Orientation orientation) const
 {
-    //ScopedTimer t1("multipass_baseline");
-
-    std::random_device rd;
-    std::mt19937 gen(rd());
-
+    static const auto timerId = ScopedTimer::intern("Graph::countFourCycles");
+    ScopedTimer t1(timerId);
+    FourCycleCounts result;
+
+    // Higher ranked nodes are the wedge endpoints that do the work, so hubs respectively
+    // the densest core come last.
+    std::vector<node> order;
+    if (orientation == Orientation::Degeneracy) {
+        order = degeneracyOrder();
+    } else {
+        order = computeOrdering(NodeOrdering::Degree);
+        std::reverse(order.begin(), order.end());
+    }
+    std::vector<int> rank(n());
+    for (int i = 0; i < n(); ++i) {
+        rank[order[i]] = i;
+    }
+    RankedAdjacency adj = rankedAdjacency(_adjList, order, rank);
 
-    Graph sampleGraph;
-    std::unordered_map<int, int> sampleNodesReMapping;
-    node nextNode = 0;
+    if (not local) {
+        std::vector<long long> unused;
+        result.total = countOrientedWedges<false>(adj, unused, unused);
+        return result;
+    }
 
-    auto getMappedNode = [&](node original) -> node {
-        if (sampleNodesReMapping.find(original) == sampleNodesReMapping.end()) {
-            sampleNodesReMapping[original] = nextNode++;
+    adj.edgeIds.assign(adj.neighbors.size(), -1);
+    for (int r = 0; r < n(); ++r) {
+        for (size_t i = adj.offsets[r]; i < adj.offsets[r + 1]; ++i) {
+            const int s = adj.neighbors[i];
+            if (s < r) continue;
+            adj.edgeIds[i] = adj.numEdges;
+            adj.edgeIds[adj.slot(s, r)] = adj.numEdges;
+            adj.numEdges++;
         }
-        return sampleNodesReMapping[original];
-    };
-
-
-    int reservoirsize = std::min({k,m()});
+    }
 
-    std::vector<std::pair<node,node>> sampledEdgeReservoir(reservoirsize);
-    int processedEdges = 0;
+    std::vector<long long> perRank(n(), 0);
+    std::vector<long long> perEdgeId(adj.numEdges, 0);
+    result.total = countOrientedWedges<true>(adj, perRank, perEdgeId);
 
-    {
-        //ScopedTimer t3("multipass_baseline::1st-pass");
-        //1st Pass
-        for (const auto& edge : _edgeList) {
-            if (processedEdges < reservoirsize) {
-                sampledEdgeReservoir[processedEdges] = edge;
-                processedEdges++;
-                if (processedEdges == reservoirsize) {
-                    std::shuffle(sampledEdgeReservoir.begin(), sampledEdgeReservoir.end(), gen);
-                } 
-                continue;
-            }
-            else {
-                std::uniform_int_distribution<int> dist(0, processedEdges);
-                int index = dist(gen);
-                if (index < reservoirsize) {
-                    sampledEdgeReservoir[index] = edge;
-                }
-            }
-            processedEdges++;
-        }
+    result.perNode.resize(n());
+    for (int r = 0; r < n(); ++r) {
+        result.perNode[order[r]] = perRank[r];
+    }
+    result.perEdge.resize(_edgeList.size());
+    #pragma omp parallel for
+    for (size_t i = 0; i < _edgeList.size(); ++i) {
+        auto [u, v] = _edgeList[i];
+        result.perEdge[i] = perEdgeId[adj.edgeIds[adj.slot(rank[u], rank[v])]];
+    }
+    return result;
+}
 
-        for (const auto& [u, v] : sampledEdgeReservoir) {
-            int mappedU = getMappedNode(u);
-            int mappedV = getMappedNode(v);
-            sampleGraph.addEdge(mappedU, mappedV, true);
-        }
+void Graph::writeRankedCSR(const std::string& filename) const
+{
+    static const auto timerId = ScopedTimer::intern("Graph::writeRankedCSR");
+    ScopedTimer t1(timerId);
+    std::vector<node> order = computeOrdering(NodeOrdering::Degree);
+    std::reverse(order.begin(), order.end());
+    std::vector<int> rank(n());
+    for (int i = 0; i < n(); ++i) {
+        rank[order[i]] = i;
     }
+    const RankedAdjacency adj = rankedAdjacency(_adjList, order, rank);
 
-    long long sampleCount = 0;
-    {
-        //ScopedTimer t3("multipass_baseline::2nd-pass");
-        //2nd Pass
-        for (const auto& edge : _edgeList) {
-            auto [u, v] = edge;
-            if (not sampleNodesReMapping.contains(u) or not sampleNodesReMapping.contains(v)) continue; //not induced
-            int mappedU = getMappedNode(u);
-            int mappedV = getMappedNode(v);
-            sampleCount += sampleGraph.countSquaresCompletedByEdge(mappedU,mappedV);
-        }
+    std::ofstream out(filename, std::ios::binary);
+    if (!out.is_open()) {
+        throw std::runtime_error("Could not open file: " + filename);
     }
+    const uint64_t header[2] = {adj.offsets.size() - 1, adj.neighbors.size()};
+    const std::vector<uint64_t> offsets(adj.offsets.begin(), adj.offsets.end());
+    out.write(RankedCSRMagic, sizeof(RankedCSRMagic));
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint64_t));
+    out.write(reinterpret_cast<const char*>(adj.neighbors.data()), adj.neighbors.size() * sizeof(int));
+    if (!out) {
+        throw std::runtime_error("Could not write file: " + filename);
+    }
+}
+
+EstimatorResult Graph::EIS(int k, int s, std::unordered_map<node, double>* localEstimates) const
+{
+    FusedEstimators estimators;
+    estimators.add(std::make_unique<EISConsumer>(k, s, localEstimates));
+    EdgeListStream stream(_edgeList);
+    return estimators.run(stream)[0];
+}
 
-    double prob = 1.0 * sampleGraph.m() / m();
 
-    long long estimate = std::llround(sampleCount/prob/prob/prob/4);
+EstimatorResult Graph::NIS(int k) const
+{
+    static const auto timerId = ScopedTimer::intern("Graph::NIS");
+    ScopedTimer t1(timerId);
+    FusedEstimators estimators;
+    estimators.add(std::make_unique<NISConsumer>(k));
+    EdgeListStream stream(_edgeList);
+    return estimators.run(stream)[0];
+}
 
-    return estimate;
+
+EstimatorResult Graph::multipass_baseline(int k) const
+{
+    static const auto timerId = ScopedTimer::intern("Graph::multipass_baseline");
+    ScopedTimer t1(timerId);
+    FusedEstimators estimators;
+    estimators.add(std::make_unique<ThreeESConsumer>(k));
+    EdgeListStream stream(_edgeList);
+    return estimators.run(stream)[0];
 }
 
 
 long long Graph::countSquaresCompletedByEdge(node u,node v) const {
-    //ScopedTimer t("Graph::countSquaresCompletedByEdge");
+    static const auto timerId = ScopedTimer::intern("Graph::countSquaresCompletedByEdge");
+    ScopedTimer t(timerId);
 
     long long count=0;
     for (int neighborU : _adjList[u]) {
@@ -411,4 +876,112 @@ long long Graph::countSquaresCompletedByEdge(node u,node v) const {
         }
     }
     return count;
-}
\ No newline at end of file
+}
+
+
+// Number of common elements of two sorted lists; searches the longer one if they differ a lot in size
+static long long intersectionSize(const std::vector<Graph::node>& a, const std::vector<Graph::node>& b)
+{
+    if (a.size() > b.size()) return intersectionSize(b, a);
+    long long count = 0;
+    if (a.size() * 16 < b.size()) {
+        auto from = b.begin();
+        for (Graph::node x : a) {
+            from = std::lower_bound(from, b.end(), x);
+            if (from == b.end()) break;
+            if (*from == x) count++;
+        }
+        return count;
+    }
+    auto i = a.begin(), j = b.begin();
+    while (i != a.end() and j != b.end()) {
+        if (*i < *j) ++i;
+        else if (*j < *i) ++j;
+        else { ++count; ++i; ++j; }
+    }
+    return count;
+}
+
+uint64_t Graph::edgeKey(node u, node v)
+{
+    if (u > v) std::swap(u, v);
+    return (static_cast<uint64_t>(static_cast<uint32_t>(u)) << 32) | static_cast<uint32_t>(v);
+}
+
+void Graph::startFourCycleCount()
+{
+    if (_fourCycles) return;
+    finalizeAdjacency();
+    // Parallel edges of the input are dropped like in the adjacency lists, keeping the first
+    _edgeIndex.clear();
+    _edgeIndex.reserve(_edgeList.size());
+    size_t kept = 0;
+    for (size_t i = 0; i < _edgeList.size(); ++i) {
+        if (not _edgeIndex.emplace(edgeKey(_edgeList[i].first, _edgeList[i].second), kept).second) continue;
+        _edgeList[kept++] = _edgeList[i];
+    }
+    _edgeList.resize(kept);
+    _timestamps.clear();
+    _fourCycles = countFourCycles().total;
+}
+
+c4count Graph::fourCycles() const
+{
+    return _fourCycles ? *_fourCycles : countFourCycles().total;
+}
+
+long long Graph::fourCyclesClosedBy(node u, node v) const
+{
+    if (degree(u) > degree(v)) std::swap(u, v);
+    long long count = 0;
+    for (node a : _adjList[u]) {
+        count += intersectionSize(_adjList[a], _adjList[v]);
+    }
+    return count;
+}
+
+void Graph::insertEdge(node u, node v)
+{
+    if (u < 0 or v < 0) throw std::out_of_range("Node index out of range.");
+    if (u == v) return;
+    startFourCycleCount();
+    if (std::max(u, v) >= n()) _adjList.resize(std::max(u, v) + 1);
+    auto& neighborsU = _adjList[u];
+    auto& neighborsV = _adjList[v];
+    auto positionU = std::lower_bound(neighborsU.begin(), neighborsU.end(), v);
+    if (positionU != neighborsU.end() and *positionU == v) {
+        throw std::runtime_error("Insertion of an edge already in the graph.");
+    }
+    *_fourCycles += fourCyclesClosedBy(u, v);
+    neighborsU.insert(positionU, v);
+    neighborsV.insert(std::lower_bound(neighborsV.begin(), neighborsV.end(), u), u);
+
+    _edgeIndex[edgeKey(u, v)] = _edgeList.size();
+    _edgeList.emplace_back(u, v);
+    _timestamps.clear();
+}
+
+void Graph::deleteEdge(node u, node v)
+{
+    startFourCycleCount();
+    if (u < 0 or v < 0 or std::max(u, v) >= n()) throw std::runtime_error("Deletion of an edge not in the graph.");
+    auto& neighborsU = _adjList[u];
+    auto& neighborsV = _adjList[v];
+    auto positionU = std::lower_bound(neighborsU.begin(), neighborsU.end(), v);
+    if (positionU == neighborsU.end() or *positionU != v) {
+        throw std::runtime_error("Deletion of an edge not in the graph.");
+    }
+    neighborsU.erase(positionU);
+    neighborsV.erase(std::lower_bound(neighborsV.begin(), neighborsV.end(), u));
+    *_fourCycles -= fourCyclesClosedBy(u, v);
+
+    auto it = _edgeIndex.find(edgeKey(u, v));
+    const size_t position = it->second;
+    _edgeIndex.erase(it);
+    if (position + 1 != _edgeList.size()) {
+        _edgeList[position] = _edgeList.back();
+        _edgeIndex[edgeKey(_edgeList[position].first, _edgeList[position].second)] = position;
+    }
+    _edgeList.pop_back();
+    _timestamps.clear();
+}
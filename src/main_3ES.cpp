@@ -2,28 +2,28 @@
 #include <iostream>
 #include <basics/parms.hpp>
 #include <basics/timer.hpp>
+#include <basics/report.hpp>
+#include <basics/driver.hpp>
 
 int main(int argc, char **argv) {
-    Parms.read_parameters(argc,argv); 
+    Parms.read_parameters(argc,argv);
+    RunReport::keepSamples(true);
     {
         ScopedTimer t1("main");
 
         Graph graph;
         {
             ScopedTimer t2("IO");
-            graph.read_konect(Parms.input());
+            graph.read(Parms.input());
         }
+        RunReport::setRun("3ES", graph.n(), graph.m());
 
         int k = Parms.k();
         if (k<=0) throw std::runtime_error("invalid k");
         
-        for (int i = 0; i < Parms.reps(); ++i) {
-            ScopedTimer t("3ES");
-            long long estimate = graph.multipass_baseline(k);
-            std::cout << estimate << std::endl;
-        }
+        Repetitions::run("3ES", [&] { return graph.multipass_baseline(k); });
     }
-    ScopedTimer::print_timers();
+    RunReport::print();
     return 0;
 }
 
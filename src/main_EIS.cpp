@@ -1,28 +1,50 @@
 #include "graph.hpp"
+#include "memory_budget.hpp"
 #include <iostream>
+#include <fstream>
+#include <map>
 #include <basics/parms.hpp>
 #include <basics/timer.hpp>
+#include <basics/report.hpp>
+#include <basics/driver.hpp>
 
 int main(int argc, char **argv) {
-    Parms.read_parameters(argc,argv); 
+    Parms.read_parameters(argc,argv);
+    RunReport::keepSamples(true);
     {
         ScopedTimer t1("main");
 
         Graph graph;
         {
             ScopedTimer t2("IO");
-            graph.read_konect(Parms.input());
+            graph.read(Parms.input());
         }
+        RunReport::setRun("EIS", graph.n(), graph.m());
+        MemoryBudget::applyParameters(graph, 1);
 
         int k = Parms.k();
         if (k<=0) throw std::runtime_error("invalid k");
         
-        for (int i = 0; i < Parms.reps(); ++i) {
-            ScopedTimer t("EIS");
-            long long estimate = graph.EIS(k,1);
-            std::cout << estimate << std::endl;
+        bool local = not Parms.nodeCounts().empty();
+        std::map<Graph::node, double> localEstimates; // summed over all reps
+        std::unordered_map<Graph::node, double> repLocalEstimates;
+
+        int reps = Repetitions::run("EIS", [&] {
+            EstimatorResult result = graph.EIS(k,1, local ? &repLocalEstimates : nullptr);
+            for (const auto& [u, localEstimate] : repLocalEstimates) {
+                localEstimates[u] += localEstimate;
+            }
+            return result;
+        });
+
+        if (local) {
+            // Node ids of the input file, see Graph::inputId
+            std::ofstream out(Parms.nodeCounts());
+            for (const auto& [u, localEstimate] : localEstimates) {
+                out << graph.inputId(u) << "\t" << Estimate(localEstimate / reps) << "\n";
+            }
         }
     }
-    ScopedTimer::print_timers();
+    RunReport::print();
     return 0;
 }
@@ -1,30 +1,52 @@
 #include "graph.hpp"
+#include "memory_budget.hpp"
 #include <iostream>
+#include <fstream>
+#include <map>
 #include <basics/parms.hpp>
 #include <basics/timer.hpp>
+#include <basics/report.hpp>
+#include <basics/driver.hpp>
 
 int main(int argc, char **argv) {
-    Parms.read_parameters(argc,argv); 
+    Parms.read_parameters(argc,argv);
+    RunReport::keepSamples(true);
     {
         ScopedTimer t1("main");
 
         Graph graph;
         {
             ScopedTimer t2("IO");
-            graph.read_konect(Parms.input());
+            graph.read(Parms.input());
         }
+        RunReport::setRun("EISm", graph.n(), graph.m());
+        MemoryBudget::applyParameters(graph, Parms.s());
         
         int k = Parms.k();
         int s = Parms.s();
         if (k<=0) throw std::runtime_error("invalid k");
         if (s<=0 or s>k) throw std::runtime_error("invalid s");
         
-        for (int i = 0; i < Parms.reps(); ++i) {
-            ScopedTimer t("EISm");
-            long long estimate = graph.EIS(k,s);
-            std::cout << estimate << std::endl;
+        bool local = not Parms.nodeCounts().empty();
+        std::map<Graph::node, double> localEstimates; // summed over all reps
+        std::unordered_map<Graph::node, double> repLocalEstimates;
+
+        int reps = Repetitions::run("EISm", [&] {
+            EstimatorResult result = graph.EIS(k,s, local ? &repLocalEstimates : nullptr);
+            for (const auto& [u, localEstimate] : repLocalEstimates) {
+                localEstimates[u] += localEstimate;
+            }
+            return result;
+        });
+
+        if (local) {
+            // Node ids of the input file, see Graph::inputId
+            std::ofstream out(Parms.nodeCounts());
+            for (const auto& [u, localEstimate] : localEstimates) {
+                out << graph.inputId(u) << "\t" << Estimate(localEstimate / reps) << "\n";
+            }
         }
     }
-    ScopedTimer::print_timers();
+    RunReport::print();
     return 0;
 }
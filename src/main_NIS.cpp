@@ -2,27 +2,27 @@
 #include <iostream>
 #include <basics/parms.hpp>
 #include <basics/timer.hpp>
+#include <basics/report.hpp>
+#include <basics/driver.hpp>
 
 int main(int argc, char **argv) {
-    Parms.read_parameters(argc,argv); 
+    Parms.read_parameters(argc,argv);
+    RunReport::keepSamples(true);
     {
         ScopedTimer t1("main");
 
         Graph graph;
         {
             ScopedTimer t2("IO");
-            graph.read_konect(Parms.input());
+            graph.read(Parms.input());
         }
+        RunReport::setRun("NIS", graph.n(), graph.m());
         
         int k = Parms.k();
         if (k<=0) throw std::runtime_error("invalid k");
         
-        for (int i = 0; i < Parms.reps(); ++i) {
-            ScopedTimer t("NIS");
-            long long estimate = graph.NIS(k);
-            std::cout << estimate << std::endl;
-        }
+        Repetitions::run("NIS", [&] { return graph.NIS(k); });
     }
-    ScopedTimer::print_timers();
+    RunReport::print();
     return 0;
 }
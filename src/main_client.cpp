@@ -0,0 +1,51 @@
+#include "server.hpp"
+#include <iostream>
+#include <basics/cxxopts.hpp>
+
+// Sends the request given on the command line, or every line of stdin, to eisd and prints the
+// responses. Exits with 1 if a request failed.
+int main(int argc, char **argv) {
+    cxxopts::Options options("eis-client", "Sends requests to eisd, e.g. eis-client estimate caida EISm 20000 8.");
+    options.add_options()
+        ("request", "Words of the request. Without them, one request is read per line of stdin.", cxxopts::value<std::vector<std::string>>())
+        ("socket", "Path of the socket.", cxxopts::value<std::string>()->default_value("/tmp/eisd.sock"))
+        ("h,help", "Print this information.");
+    options.parse_positional({"request"});
+
+    std::vector<std::string> words;
+    std::string socketPath;
+    try {
+        auto parse_result = options.parse(argc, argv);
+        if (parse_result.count("help")) {
+            std::cout << options.show_positional_help().help() << std::endl;
+            return 0;
+        }
+        if (parse_result.count("request")) words = parse_result["request"].as<std::vector<std::string>>();
+        socketPath = parse_result["socket"].as<std::string>();
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error parsing options: " << e.what() << std::endl;
+        std::cerr << options.show_positional_help().help() << std::endl;
+        return 1;
+    }
+
+    EstimateClient client(socketPath);
+    bool failed = false;
+    auto send = [&](const std::string& request) {
+        const std::string response = client.request(request);
+        std::cout << response << std::endl;
+        failed = failed or response.rfind("error", 0) == 0;
+    };
+    if (not words.empty()) {
+        std::string request;
+        for (const auto& word : words) {
+            request += (request.empty() ? "" : " ") + word;
+        }
+        send(request);
+    } else {
+        for (std::string line; std::getline(std::cin, line);) {
+            if (not line.empty()) send(line);
+        }
+    }
+    return failed ? 1 : 0;
+}
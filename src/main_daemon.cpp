@@ -0,0 +1,61 @@
+#include "server.hpp"
+#include <iostream>
+#include <thread>
+#include <basics/cxxopts.hpp>
+#include <basics/random.hpp>
+#include <basics/report.hpp>
+#include <basics/timer.hpp>
+
+int main(int argc, char **argv) {
+    cxxopts::Options options("eisd", "Holds graphs in memory and answers estimate requests on a Unix domain socket.");
+    options.add_options()
+        ("graph", "Graph to load, as NAME=FILE or FILE (named by its file name). Can be given several times and positional.", cxxopts::value<std::vector<std::string>>())
+        ("socket", "Path of the socket.", cxxopts::value<std::string>()->default_value("/tmp/eisd.sock"))
+        ("w,workers", "Connections served concurrently. 0 uses one per hardware thread.", cxxopts::value<int>()->default_value("0"))
+        ("seed", "Seed for all random generators. Random if not given.", cxxopts::value<uint64_t>())
+        ("t,threads", "Number of threads for parallel code paths of a single request. 0 divides the hardware threads among the workers.", cxxopts::value<int>()->default_value("0"))
+        ("h,help", "Print this information.");
+    options.parse_positional({"graph"});
+
+    std::vector<std::string> graphs;
+    std::string socketPath;
+    int workers, threads;
+    try {
+        auto parse_result = options.parse(argc, argv);
+        if (parse_result.count("help")) {
+            std::cout << options.show_positional_help().help() << std::endl;
+            return 0;
+        }
+        if (parse_result.count("graph")) graphs = parse_result["graph"].as<std::vector<std::string>>();
+        socketPath = parse_result["socket"].as<std::string>();
+        workers = parse_result["workers"].as<int>();
+        if (workers <= 0) workers = std::max(1u, std::thread::hardware_concurrency());
+        if (parse_result.count("seed")) Seeds::set(parse_result["seed"].as<uint64_t>());
+        threads = parse_result["threads"].as<int>();
+        if (threads < 0) throw std::invalid_argument("invalid number of threads");
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error parsing options: " << e.what() << std::endl;
+        std::cerr << options.show_positional_help().help() << std::endl;
+        return 1;
+    }
+
+    EstimateServer server;
+    for (const auto& graph : graphs) {
+        const auto separator = graph.find('=');
+        std::string name, file;
+        if (separator != std::string::npos) {
+            name = graph.substr(0, separator);
+            file = graph.substr(separator + 1);
+        } else {
+            file = graph;
+            name = file.substr(file.find_last_of('/') + 1);
+        }
+        server.load(name, file);
+        std::cerr << "loaded " << name << " from " << file << std::endl;
+    }
+    std::cerr << "listening on " << socketPath << " with " << workers << " workers" << std::endl;
+    server.serve(socketPath, workers, threads);
+    ScopedTimer::print_timers();
+    return 0;
+}
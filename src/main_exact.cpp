@@ -0,0 +1,49 @@
+#include "graph.hpp"
+#include <iostream>
+#include <fstream>
+#include <basics/parms.hpp>
+#include <basics/timer.hpp>
+#include <basics/report.hpp>
+
+int main(int argc, char **argv) {
+    Parms.read_parameters(argc,argv);
+    {
+        ScopedTimer t1("main");
+
+        Graph graph;
+        {
+            ScopedTimer t2("IO");
+            graph.read(Parms.input());
+        }
+        RunReport::setRun("exact", graph.n(), graph.m());
+
+        bool local = not Parms.nodeCounts().empty() or not Parms.edgeCounts().empty();
+
+        Graph::FourCycleCounts counts;
+        for (int i = 0; i < Parms.reps(); ++i) {
+            ScopedTimer t("exact");
+            counts = graph.countFourCycles(local);
+            RunReport::addExact(counts.total);
+        }
+
+        // Local counts use the node ids of the input file, see Graph::inputId
+        if (not Parms.nodeCounts().empty()) {
+            ScopedTimer t("write-node-counts");
+            std::ofstream out(Parms.nodeCounts());
+            for (int u = 0; u < graph.n(); ++u) {
+                out << graph.inputId(u) << "\t" << counts.perNode[u] << "\n";
+            }
+        }
+        if (not Parms.edgeCounts().empty()) {
+            ScopedTimer t("write-edge-counts");
+            std::ofstream out(Parms.edgeCounts());
+            const auto& edges = graph.edges();
+            for (size_t i = 0; i < edges.size(); ++i) {
+                auto [u, v] = edges[i];
+                out << graph.inputId(u) << "\t" << graph.inputId(v) << "\t" << counts.perEdge[i] << "\n";
+            }
+        }
+    }
+    RunReport::print();
+    return 0;
+}
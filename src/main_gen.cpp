@@ -0,0 +1,84 @@
+#include "generators.hpp"
+#include <iostream>
+#include <basics/cxxopts.hpp>
+#include <basics/random.hpp>
+#include <basics/timer.hpp>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+int main(int argc, char **argv) {
+    cxxopts::Options options("gen", "Writes a random graph in KONECT or binary format.");
+    options.add_options()
+        ("output", "Output file. Mandatory. Can be given positional.", cxxopts::value<std::string>())
+        ("model", "er (Erdos-Renyi), chunglu (power-law), rmat or bip (random bipartite).", cxxopts::value<std::string>()->default_value("er"))
+        ("n", "Number of nodes (bip: left side, rmat: rounded up to a power of two).", cxxopts::value<long long>()->default_value("100000"))
+        ("n-right", "bip: Number of nodes on the right side.", cxxopts::value<long long>()->default_value("100000"))
+        ("m", "Number of edges.", cxxopts::value<long long>()->default_value("1000000"))
+        ("exponent", "chunglu: Power-law exponent.", cxxopts::value<double>()->default_value("2.5"))
+        ("a", "rmat: Probability of the top left quadrant.", cxxopts::value<double>()->default_value("0.57"))
+        ("b", "rmat: Probability of the top right quadrant.", cxxopts::value<double>()->default_value("0.19"))
+        ("c", "rmat: Probability of the bottom left quadrant.", cxxopts::value<double>()->default_value("0.19"))
+        ("multigraph", "Keep parallel edges instead of drawing repeated edges again.")
+        ("format", "konect or binary.", cxxopts::value<std::string>()->default_value("konect"))
+        ("seed", "Seed. Random if not given.", cxxopts::value<uint64_t>())
+        ("t,threads", "Number of threads. 0 uses all.", cxxopts::value<int>()->default_value("0"))
+        ("h,help", "Print this information.");
+    options.parse_positional({"output"});
+
+    GraphGenerator::Config config;
+    GraphGenerator::Format format;
+    std::string output;
+    try {
+        auto parse_result = options.parse(argc, argv);
+        if (parse_result.count("help") or not parse_result.count("output")) {
+            std::cout << options.show_positional_help().help() << std::endl;
+            return parse_result.count("help") ? 0 : 1;
+        }
+        output = parse_result["output"].as<std::string>();
+
+        const std::string model = parse_result["model"].as<std::string>();
+        if (model == "er") config.model = GraphGenerator::Model::ErdosRenyi;
+        else if (model == "chunglu") config.model = GraphGenerator::Model::ChungLu;
+        else if (model == "rmat") config.model = GraphGenerator::Model::RMAT;
+        else if (model == "bip") config.model = GraphGenerator::Model::Bipartite;
+        else throw std::invalid_argument("unknown model " + model);
+
+        const std::string formatName = parse_result["format"].as<std::string>();
+        if (formatName == "konect") format = GraphGenerator::Format::Konect;
+        else if (formatName == "binary") format = GraphGenerator::Format::Binary;
+        else throw std::invalid_argument("unknown format " + formatName);
+
+        config.n = parse_result["n"].as<long long>();
+        config.nRight = parse_result["n-right"].as<long long>();
+        config.m = parse_result["m"].as<long long>();
+        config.exponent = parse_result["exponent"].as<double>();
+        config.a = parse_result["a"].as<double>();
+        config.b = parse_result["b"].as<double>();
+        config.c = parse_result["c"].as<double>();
+        config.multigraph = parse_result.count("multigraph") > 0;
+        config.seed = parse_result.count("seed") ? parse_result["seed"].as<uint64_t>() : Seeds::next();
+#ifdef _OPENMP
+        if (parse_result["threads"].as<int>() > 0) {
+            omp_set_num_threads(parse_result["threads"].as<int>());
+        }
+#endif
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error parsing options: " << e.what() << std::endl;
+        std::cerr << options.show_positional_help().help() << std::endl;
+        return 1;
+    }
+
+    try {
+        ScopedTimer t("gen");
+        GraphGenerator generator(config);
+        generator.write(output, format);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    ScopedTimer::print_timers();
+    return 0;
+}
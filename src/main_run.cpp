@@ -0,0 +1,127 @@
+#include "eis.hpp"
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <basics/parms.hpp>
+#include <basics/timer.hpp>
+#include <basics/report.hpp>
+#include <basics/driver.hpp>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Runs several algorithms on one copy of the graph, e.g. eis-run --algo=EIS,NIS,3ES,exact graph.
+// Every algorithm draws from its own seed sequence, so a seeded run gives the same estimates
+// with and without --concurrent. With --fused, the sampling algorithms share one scan of the edges
+// per pass instead (FusedEstimators); each repetition then runs all of them. --stream does the same
+// on a binary input file without loading it (BinaryFileStream), so exact and --mem-budget are not
+// available there.
+int main(int argc, char **argv) {
+    Parms.read_parameters(argc,argv);
+    RunReport::keepSamples(true);
+    {
+        ScopedTimer t1("main");
+
+        std::vector<Estimator::Algorithm> algorithms;
+        std::stringstream names(Parms.algo());
+        for (std::string name; std::getline(names, name, ',');) {
+            if (not name.empty()) algorithms.push_back(Estimator::parse(name));
+        }
+        if (algorithms.empty()) throw std::invalid_argument("no algorithm given");
+
+        // The sampling algorithms with one scan of the stream per pass, for every repetition
+        static const auto timerId = ScopedTimer::intern("fused");
+        auto runFused = [&](const std::vector<size_t>& fused, EdgeStream& stream, long long n) {
+            for (int r = 0; r < Parms.reps() and not fused.empty(); ++r) {
+                FusedEstimators estimators;
+                for (size_t i : fused) {
+                    estimators.add(Estimator::consumer(algorithms[i], Parms.k(), Parms.s()));
+                }
+                {
+                    ScopedTimer t(timerId);
+                    estimators.scan(stream);
+                }
+                for (size_t j = 0; j < fused.size(); ++j) {
+                    RunReport::setRun(Estimator::name(algorithms[fused[j]]), n, stream.size());
+                    RunReport::addResult(estimators.estimate(j));
+                }
+            }
+        };
+
+        if (Parms.stream()) {
+            if (Parms.anytime()) throw std::invalid_argument("--stream runs a fixed number of repetitions");
+            if (not Parms.memBudget().empty()) throw std::invalid_argument("--mem-budget needs the graph in memory");
+            BinaryFileStream stream(Parms.input());
+            std::vector<size_t> fused;
+            for (size_t i = 0; i < algorithms.size(); ++i) {
+                if (algorithms[i] == Estimator::Algorithm::Exact) throw std::invalid_argument("exact needs the graph in memory, not --stream");
+                RunReport::setRun(Estimator::name(algorithms[i]), stream.n(), stream.size());
+                fused.push_back(i);
+            }
+            runFused(fused, stream, stream.n());
+        } else {
+            Graph graph;
+            {
+                ScopedTimer t2("IO");
+                graph.read(Parms.input());
+            }
+            // All runs are registered before any result comes in, so that every printed result
+            // carries its algorithm, also with --concurrent
+            bool multipleSamples = false;
+            for (auto algorithm : algorithms) {
+                RunReport::setRun(Estimator::name(algorithm), graph.n(), graph.m());
+                multipleSamples = multipleSamples or algorithm == Estimator::Algorithm::EISm;
+            }
+            MemoryBudget::applyParameters(graph, multipleSamples ? Parms.s() : 1);
+
+            auto runAlgorithm = [&](size_t i) {
+                const std::string name = Estimator::name(algorithms[i]);
+                RunReport::setRun(name, graph.n(), graph.m());
+                Seeds::useStream(i + 1);
+                Repetitions::run(name, [&] {
+                    return Estimator::run(graph, algorithms[i], Parms.k(), Parms.s());
+                });
+            };
+
+            if (Parms.fused()) {
+                if (Parms.anytime()) throw std::invalid_argument("--fused runs a fixed number of repetitions");
+                std::vector<size_t> fused;
+                for (size_t i = 0; i < algorithms.size(); ++i) {
+                    if (algorithms[i] == Estimator::Algorithm::Exact) {
+                        runAlgorithm(i);
+                    } else {
+                        fused.push_back(i);
+                    }
+                }
+                EdgeListStream stream(graph.edges());
+                runFused(fused, stream, graph.n());
+            } else if (Parms.concurrent()) {
+                std::vector<std::thread> threads;
+                std::vector<std::exception_ptr> errors(algorithms.size());
+                for (size_t i = 0; i < algorithms.size(); ++i) {
+                    threads.emplace_back([&, i] {
+#ifdef _OPENMP
+                        // -t is set for the main thread only
+                        omp_set_num_threads(Parms.threads());
+#endif
+                        try {
+                            runAlgorithm(i);
+                        } catch (...) {
+                            errors[i] = std::current_exception();
+                        }
+                    });
+                }
+                for (auto& thread : threads) thread.join();
+                for (const auto& error : errors) {
+                    if (error) std::rethrow_exception(error);
+                }
+            } else {
+                for (size_t i = 0; i < algorithms.size(); ++i) {
+                    runAlgorithm(i);
+                }
+            }
+        }
+    }
+    RunReport::print();
+    return 0;
+}
@@ -0,0 +1,129 @@
+#include "graph.hpp"
+#include "sharded_count.hpp"
+#include <cstdlib>
+#include <iostream>
+#include <unistd.h>
+#include <basics/cxxopts.hpp>
+#include <basics/numa.hpp>
+#include <basics/report.hpp>
+#include <basics/timer.hpp>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Exact four-cycle count with one worker process per shard, see ShardedCount. The coordinator
+// writes the ranked CSR file of the graph (or uses the one of --csr), starts this executable with
+// --worker for every shard with the range of ranks it computed, and sums up their counts. On
+// other machines, run
+//   exact-sharded --worker CSR --shard I --shards P
+// with a copy of the file and add up the printed counts; without --from and --to, every such
+// worker computes the ranges itself.
+int main(int argc, char **argv) {
+    cxxopts::Options options("exact-sharded", "Exact four-cycle count by one worker process per shard.");
+    options.add_options()
+        ("input", "Graph to count. Can be given positional.", cxxopts::value<std::string>()->default_value(""))
+        ("p,shards", "Number of shards and worker processes.", cxxopts::value<int>()->default_value("2"))
+        ("csr", "Ranked CSR file of the graph. Written from the input if given, kept afterwards; a temporary file otherwise.", cxxopts::value<std::string>()->default_value(""))
+        ("worker", "Count the shard --shard of this CSR file and print the count.", cxxopts::value<std::string>()->default_value(""))
+        ("shard", "Shard of a worker.", cxxopts::value<int>()->default_value("0"))
+        ("from", "First rank of the shard of a worker. Computed from --shard if not given.", cxxopts::value<int>())
+        ("to", "End of the ranks of the shard of a worker.", cxxopts::value<int>())
+        ("t,threads", "Threads of every worker. 0 uses all.", cxxopts::value<int>()->default_value("1"))
+        ("h,help", "Print this information.");
+    options.parse_positional({"input"});
+
+    std::string input, csr, worker;
+    int shards, shard, threads;
+    int from = -1, to = -1;
+    try {
+        auto parse_result = options.parse(argc, argv);
+        if (parse_result.count("help")) {
+            std::cout << options.show_positional_help().help() << std::endl;
+            return 0;
+        }
+        input = parse_result["input"].as<std::string>();
+        csr = parse_result["csr"].as<std::string>();
+        worker = parse_result["worker"].as<std::string>();
+        shards = parse_result["shards"].as<int>();
+        shard = parse_result["shard"].as<int>();
+        threads = parse_result["threads"].as<int>();
+        if (parse_result.count("from") != parse_result.count("to")) throw std::invalid_argument("--from needs --to");
+        if (parse_result.count("from")) {
+            from = parse_result["from"].as<int>();
+            to = parse_result["to"].as<int>();
+        }
+        if (shards <= 0) throw std::invalid_argument("invalid number of shards");
+        if (threads < 0) throw std::invalid_argument("invalid number of threads");
+        if (worker.empty() and input.empty() and csr.empty()) throw std::invalid_argument("no input given");
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error parsing options: " << e.what() << std::endl;
+        std::cerr << options.show_positional_help().help() << std::endl;
+        return 1;
+    }
+#ifdef _OPENMP
+    if (threads > 0) omp_set_num_threads(threads);
+#endif
+
+    if (not worker.empty()) {
+        try {
+            // Local workers spread over the NUMA nodes, each with its threads and scratch memory on one
+            Numa::bindProcess(Numa::nodeOf(shard, shards));
+            if (to < 0) {
+                if (shard < 0 or shard >= shards) throw std::invalid_argument("invalid shard");
+                const std::vector<int> bounds = ShardedCount::shardBounds(ShardedCount::MappedCSR(worker), shards);
+                from = bounds[shard];
+                to = bounds[shard + 1];
+            }
+            std::cout << ShardedCount::countRanks(worker, from, to) << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    {
+        ScopedTimer t1("main");
+        const bool temporary = csr.empty();
+        if (temporary) {
+            char path[] = "/tmp/eis-csr-XXXXXX";
+            const int fd = mkstemp(path);
+            if (fd < 0) {
+                std::cerr << "Error: Could not create a temporary file." << std::endl;
+                return 1;
+            }
+            close(fd);
+            csr = path;
+        }
+        c4count total;
+        try {
+            if (not input.empty()) {
+                Graph graph;
+                {
+                    ScopedTimer t2("IO");
+                    graph.read(input);
+                }
+                graph.writeRankedCSR(csr);
+            }
+            std::vector<int> bounds;
+            {
+                const ShardedCount::MappedCSR mapped(csr);
+                RunReport::setRun("exact-sharded", mapped.n(), mapped.offsets()[mapped.n()] / 2);
+                bounds = ShardedCount::shardBounds(mapped, shards);
+            }
+
+            // Workers run this executable again
+            const std::vector<std::string> command = {"/proc/self/exe", "--worker", csr, "--shards", std::to_string(shards), "--threads", std::to_string(threads)};
+            total = ShardedCount::run(command, bounds);
+        } catch (const std::exception& e) {
+            if (temporary) unlink(csr.c_str());
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+        if (temporary) unlink(csr.c_str());
+        RunReport::addExact(total);
+    }
+    RunReport::print();
+    return 0;
+}
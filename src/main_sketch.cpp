@@ -0,0 +1,117 @@
+#include "graph.hpp"
+#include "sketch.hpp"
+#include <iostream>
+#include <basics/cxxopts.hpp>
+#include <basics/random.hpp>
+#include <basics/report.hpp>
+#include <basics/timer.hpp>
+
+static const char* Usage =
+    "sketch sample SHARD --shard I --seed SEED -k K -s S --out FILE\n"
+    "sketch merge SKETCH... --out FILE\n"
+    "sketch induce SHARD --sketch MERGED --out FILE\n"
+    "sketch count SKETCH...";
+
+static Sketch mergeAll(const std::vector<std::string>& files)
+{
+    if (files.empty()) throw std::invalid_argument("no sketches given");
+    Sketch merged(files[0]);
+    for (size_t i = 1; i < files.size(); ++i) {
+        merged.merge(Sketch(files[i]));
+    }
+    return merged;
+}
+
+// Sharded EIS (EISm) and NIS, one step per call, see Sketch: every shard samples its edges, the
+// sketches are merged, every shard collects the induced edges on the merged sketch, and count
+// merges these and prints the estimates.
+int main(int argc, char **argv) {
+    cxxopts::Options options("sketch", std::string("Mergeable EIS and NIS sketches of sharded graphs.\n") + Usage);
+    options.add_options()
+        ("command", "sample, merge, induce or count.", cxxopts::value<std::string>())
+        ("files", "Shard graph (sample, induce) or sketch files (merge, count).", cxxopts::value<std::vector<std::string>>())
+        ("o,out", "Sketch file to write.", cxxopts::value<std::string>()->default_value(""))
+        ("sketch", "induce: Merged sketch of all first passes.", cxxopts::value<std::string>()->default_value(""))
+        ("shard", "sample: Number of the shard, which selects its random stream.", cxxopts::value<int>()->default_value("0"))
+        ("k", "sample: Number of edges stored by EIS and NIS.", cxxopts::value<int>()->default_value("20000"))
+        ("s", "sample: EISm with s samples which in total use k edges.", cxxopts::value<int>()->default_value("1"))
+        ("seed", "sample: Seed for all random generators, the same for all shards.", cxxopts::value<uint64_t>())
+        ("h,help", "Print this information.");
+    options.parse_positional({"command", "files"});
+
+    std::string command, out, sketchFile;
+    std::vector<std::string> files;
+    int shard, k, s;
+    try {
+        auto parse_result = options.parse(argc, argv);
+        if (parse_result.count("help") or not parse_result.count("command")) {
+            std::cout << options.show_positional_help().help() << std::endl;
+            return parse_result.count("help") ? 0 : 1;
+        }
+        command = parse_result["command"].as<std::string>();
+        if (parse_result.count("files")) files = parse_result["files"].as<std::vector<std::string>>();
+        out = parse_result["out"].as<std::string>();
+        sketchFile = parse_result["sketch"].as<std::string>();
+        shard = parse_result["shard"].as<int>();
+        k = parse_result["k"].as<int>();
+        s = parse_result["s"].as<int>();
+        if (parse_result.count("seed")) {
+            Seeds::set(parse_result["seed"].as<uint64_t>());
+        } else if (command == "sample") {
+            throw std::invalid_argument("sample needs --seed, the NIS samples of the shards share its hash function");
+        }
+        if (shard < 0) throw std::invalid_argument("invalid shard");
+        if ((command == "sample" or command == "induce") and files.size() != 1) throw std::invalid_argument(command + " needs one shard");
+        if (command != "count" and out.empty()) throw std::invalid_argument(command + " needs --out");
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error parsing options: " << e.what() << std::endl;
+        std::cerr << options.show_positional_help().help() << std::endl;
+        return 1;
+    }
+
+    try {
+        ScopedTimer t1("main");
+        if (command == "sample") {
+            const uint64_t hashSeed = Seeds::next();
+            Seeds::useStream(shard + 1); // independent reservoirs on every shard
+            Sketch sketch(k, s, hashSeed);
+            Graph graph;
+            {
+                ScopedTimer t2("IO");
+                graph.read(files[0]);
+            }
+            EdgeListStream stream(graph.edges());
+            sketch.sample(stream);
+            sketch.write(out);
+        } else if (command == "merge") {
+            mergeAll(files).write(out);
+        } else if (command == "induce") {
+            if (sketchFile.empty()) throw std::invalid_argument("induce needs --sketch");
+            Sketch sketch(sketchFile);
+            Graph graph;
+            {
+                ScopedTimer t2("IO");
+                graph.read(files[0]);
+            }
+            EdgeListStream stream(graph.edges());
+            sketch.induce(stream);
+            sketch.write(out);
+        } else if (command == "count") {
+            Sketch sketch = mergeAll(files);
+            const Estimate eis = sketch.estimateEIS().estimate;
+            std::cout << "EIS\t" << eis << std::endl;
+            std::cout << "NIS\t" << sketch.estimateNIS().estimate << std::endl;
+        } else {
+            throw std::invalid_argument("unknown command: " + command);
+        }
+    }
+    catch (const std::exception& e) {
+        // e.g. count on sketches that missed the induce step
+        std::cerr << "Error: " << e.what() << std::endl;
+        std::cerr << Usage << std::endl;
+        return 1;
+    }
+    ScopedTimer::print_timers();
+    return 0;
+}
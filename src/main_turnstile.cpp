@@ -0,0 +1,61 @@
+#include "eis.hpp"
+#include "turnstile.hpp"
+#include <iostream>
+#include <sstream>
+#include <basics/parms.hpp>
+#include <basics/timer.hpp>
+#include <basics/report.hpp>
+#include <basics/driver.hpp>
+
+// Runs the algorithms of --algo on a fully dynamic stream of signed edge updates and estimates
+// the four-cycles of the graph left at the end, e.g. turnstile --algo=EIS,NIS,exact updates.tsv
+int main(int argc, char **argv) {
+    Parms.read_parameters(argc,argv);
+    RunReport::keepSamples(true);
+    {
+        ScopedTimer t1("main");
+
+        std::vector<Estimator::Algorithm> algorithms;
+        std::stringstream names(Parms.algo());
+        for (std::string name; std::getline(names, name, ',');) {
+            if (not name.empty()) algorithms.push_back(Estimator::parse(name));
+        }
+        if (algorithms.empty()) throw std::invalid_argument("no algorithm given");
+
+        TurnstileStream stream;
+        {
+            ScopedTimer t2("IO");
+            stream.read(Parms.input());
+        }
+        const int k = Parms.k();
+        const int s = Parms.s();
+        if (k <= 0) throw std::runtime_error("invalid k");
+        if (s <= 0 or s > k) throw std::runtime_error("invalid s");
+
+        for (auto algorithm : algorithms) {
+            const std::string name = Estimator::name(algorithm);
+            RunReport::setRun(name, stream.n(), stream.m());
+            switch (algorithm) {
+            case Estimator::Algorithm::EIS:
+                Repetitions::run(name, [&] { return stream.EIS(k, 1); });
+                break;
+            case Estimator::Algorithm::EISm:
+                Repetitions::run(name, [&] { return stream.EIS(k, s); });
+                break;
+            case Estimator::Algorithm::NIS:
+                Repetitions::run(name, [&] { return stream.NIS(k); });
+                break;
+            case Estimator::Algorithm::ThreeES:
+                Repetitions::run(name, [&] { return stream.multipass_baseline(k); });
+                break;
+            case Estimator::Algorithm::Exact: {
+                const Graph graph = stream.finalGraph();
+                RunReport::addExact(graph.countFourCycles().total);
+                break;
+            }
+            }
+        }
+    }
+    RunReport::print();
+    return 0;
+}
@@ -0,0 +1,54 @@
+#include "graph.hpp"
+#include "sliding_window.hpp"
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+#include <basics/parms.hpp>
+#include <basics/timer.hpp>
+#include <basics/report.hpp>
+#include <basics/memory.hpp>
+
+// Replays a timestamped KONECT file in time order and prints the four-cycle estimate of the
+// sliding window every --report-every edges: timestamp, estimate, sampled edges, edges in the window.
+// -k 0 keeps the whole window and prints exact counts.
+int main(int argc, char **argv) {
+    Parms.read_parameters(argc,argv);
+    {
+        ScopedTimer t1("main");
+
+        Graph graph;
+        {
+            ScopedTimer t2("IO");
+            graph.read(Parms.input());
+        }
+        const auto& timestamps = graph.timestamps();
+        if (timestamps.empty()) throw std::runtime_error("The input has no timestamps.");
+        if (Parms.window() <= 0) throw std::runtime_error("invalid window");
+        if (Parms.reportEvery() <= 0) throw std::runtime_error("invalid report-every");
+
+        // KONECT files are usually but not necessarily sorted by time
+        std::vector<size_t> order(timestamps.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return timestamps[a] < timestamps[b]; });
+
+        SlidingWindowEstimator estimator(Parms.window(), Parms.k());
+        static const auto timerId = ScopedTimer::intern("SlidingWindowEstimator::insert");
+        size_t peakBytes = 0;
+        for (size_t i = 0; i < order.size(); ++i) {
+            auto [u, v] = graph.edges()[order[i]];
+            {
+                ScopedTimer t(timerId);
+                estimator.insert(u, v, timestamps[order[i]]);
+            }
+            if ((i + 1) % Parms.reportEvery() == 0 or i + 1 == order.size()) {
+                std::cout << timestamps[order[i]] << "\t" << estimator.estimate() << "\t" << estimator.sampleEdges()
+                          << "\t" << estimator.windowEdges() << std::endl;
+                peakBytes = std::max(peakBytes, estimator.memory_usage());
+            }
+        }
+        MemoryTracker::record("SlidingWindowEstimator", peakBytes);
+    }
+    ScopedTimer::print_timers();
+    RunReport::print_memory();
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include "memory_budget.hpp"
+#include "EIS_sample.hpp"
+#include "basics/memory.hpp"
+#include "basics/parms.hpp"
+#include "basics/report.hpp"
+#include "basics/timer.hpp"
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+MemoryBudget::Model MemoryBudget::defaultModel()
+{
+    // Both endpoints of a sampled edge may be new nodes of the sample
+    const double reservoir = sizeof(Graph::edge);
+    const double mapping = 2 * (sizeof(std::pair<const int, int>) + Memory::HashNodeOverhead + sizeof(void*));
+    const double adjacency = 2 * 2 * sizeof(std::vector<int>)  // a list per color for both endpoints
+                           + 2 * 2 * sizeof(int) * 2;          // an entry per color and endpoint, vectors grow by 2x
+    // Copies of the adjacency lists, the node order and the wedge maps (one entry per wedge and endpoint)
+    const double scratch = adjacency + 2 * sizeof(int) + 2 * (sizeof(int) + Memory::TreeNodeOverhead);
+    return {reservoir + mapping + adjacency, scratch};
+}
+
+MemoryBudget::Model MemoryBudget::calibrate(const Graph& graph, size_t budget)
+{
+    static const auto timerId = ScopedTimer::intern("MemoryBudget::calibrate");
+    ScopedTimer t1(timerId);
+    const Model model = defaultModel();
+    const int k = std::min(graph.m(), std::max(1024, choose(graph, budget, 1, model).k / 16));
+    if (k <= 0) return model;
+
+    Sample sample;
+    sample.setupReservoirSampling(k);
+    for (const auto& edge : graph.edges()) {
+        sample.processForReservoirSampling(edge);
+    }
+    sample.finalizeReservoirSampling();
+    for (const auto& edge : graph.edges()) {
+        sample.collectInducedEge(edge);
+    }
+    const double sampleBytes = sample.memory_usage();
+    // Not recorded, the peaks of the report belong to the actual run
+    const double scratchBytes = sample.countingScratch();
+
+    return {1.1 * sampleBytes / k, std::max(model.scratchBytesPerEdge, scratchBytes / k)};
+}
+
+MemoryBudget::Choice MemoryBudget::choose(const Graph& graph, size_t budget, int maxS, const Model& model)
+{
+    const double used = RunReport::peakRSS();
+    if (budget <= used) {
+        throw std::runtime_error("Memory budget of " + MemoryTracker::format(budget) + " is exhausted by the "
+                                 + MemoryTracker::format(used) + " already in use.");
+    }
+    const double available = budget - used;
+    const long long m = graph.m();
+
+    Choice best{0, 0};
+    double bestVariance = 0;
+    for (int s = 1; s <= std::max(1, maxS); ++s) {
+        long long k = available / (model.sampleBytesPerEdge + model.scratchBytesPerEdge / s);
+        if (s == 1 and k >= m) {
+            // A single sample holds the whole graph, which makes the estimate exact
+            return {static_cast<int>(m), 1};
+        }
+        k = std::min(k, s * m); // samples never hold more than the whole graph
+        if (k < s) break;
+        const double variance = s / (1.0 * k * k);
+        if (best.s == 0 or variance < bestVariance) {
+            best = {static_cast<int>(std::min<long long>(k, std::numeric_limits<int>::max())), s};
+            bestVariance = variance;
+        }
+    }
+    if (best.s == 0) {
+        throw std::runtime_error("Memory budget of " + MemoryTracker::format(budget) + " does not fit a single sampled edge.");
+    }
+    return best;
+}
+
+void MemoryBudget::applyParameters(const Graph& graph, int maxS)
+{
+    if (Parms.memBudget().empty()) return;
+    const size_t budget = parse(Parms.memBudget());
+    const Model model = Parms.calibrate() ? calibrate(graph, budget) : defaultModel();
+    const Choice choice = choose(graph, budget, maxS, model);
+    Parms.setSampleSize(choice.k, choice.s);
+    std::cerr << "mem-budget " << MemoryTracker::format(budget) << ": k=" << choice.k << " s=" << choice.s
+              << " (" << model.sampleBytesPerEdge << " + " << model.scratchBytesPerEdge << "/s bytes per sampled edge)" << std::endl;
+}
+
+size_t MemoryBudget::parse(const std::string& size)
+{
+    size_t pos = 0;
+    double value = 0;
+    try {
+        value = std::stod(size, &pos);
+    } catch (const std::exception&) {
+        throw std::invalid_argument("Invalid memory size: " + size);
+    }
+    const std::string suffix = size.substr(pos);
+    double unit = 1;
+    if (not suffix.empty()) {
+        const std::string units = "KMGT";
+        auto index = units.find(std::toupper(suffix[0]));
+        const std::string rest = suffix.substr(1);
+        if (index == std::string::npos or not (rest.empty() or rest == "B" or rest == "iB")) {
+            throw std::invalid_argument("Invalid memory size: " + size);
+        }
+        for (size_t i = 0; i <= index; ++i) unit *= 1024;
+    }
+    if (value <= 0) {
+        throw std::invalid_argument("Memory size must be positive: " + size);
+    }
+    return static_cast<size_t>(value * unit);
+}
@@ -0,0 +1,288 @@
+#include "server.hpp"
+#include "eis.hpp"
+#include "basics/report.hpp"
+#include "basics/statistics.hpp"
+#include "basics/timer.hpp"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Appends what arrives on the socket to buffer until it holds a full line. False once the peer is gone.
+static bool readLine(int fd, std::string& buffer, std::string& line)
+{
+    size_t end;
+    while ((end = buffer.find('\n')) == std::string::npos) {
+        char chunk[4096];
+        ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+        if (received < 0 and errno == EINTR) continue;
+        if (received <= 0) return false;
+        buffer.append(chunk, received);
+    }
+    line = buffer.substr(0, end);
+    buffer.erase(0, end + 1);
+    if (not line.empty() and line.back() == '\r') line.pop_back();
+    return true;
+}
+
+static bool writeLine(int fd, const std::string& line)
+{
+    const std::string data = line + "\n";
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t written = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (written < 0 and errno == EINTR) continue;
+        if (written <= 0) return false;
+        sent += written;
+    }
+    return true;
+}
+
+static sockaddr_un socketAddress(const std::string& socketPath)
+{
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        throw std::invalid_argument("Socket path too long: " + socketPath);
+    }
+    std::strcpy(address.sun_path, socketPath.c_str());
+    return address;
+}
+
+static int parseNumber(const std::string& word, const std::string& what)
+{
+    size_t pos = 0;
+    int value = 0;
+    try {
+        value = std::stoi(word, &pos);
+    } catch (const std::exception&) {
+        pos = 0;
+    }
+    if (pos == 0 or pos != word.size()) {
+        throw std::invalid_argument("invalid " + what + ": " + word);
+    }
+    return value;
+}
+
+
+void EstimateServer::load(const std::string& name, const std::string& filename)
+{
+    static const auto timerId = ScopedTimer::intern("EstimateServer::load");
+    ScopedTimer t(timerId);
+    auto graph = std::make_shared<Graph>();
+    graph->read(filename);
+    std::unique_lock lock(_graphsMutex);
+    _graphs[name] = std::move(graph);
+}
+
+std::shared_ptr<const Graph> EstimateServer::graph(const std::string& name) const
+{
+    std::shared_lock lock(_graphsMutex);
+    auto it = _graphs.find(name);
+    if (it == _graphs.end()) {
+        throw std::invalid_argument("unknown graph: " + name);
+    }
+    return it->second;
+}
+
+std::string EstimateServer::handle(const std::string& request)
+{
+    std::vector<std::string> words;
+    std::istringstream in(request);
+    for (std::string word; in >> word;) {
+        words.push_back(word);
+    }
+    try {
+        if (words.empty()) throw std::invalid_argument("empty request");
+        const std::string& command = words[0];
+        if (command == "estimate") {
+            return estimate(words);
+        }
+        if (command == "load") {
+            if (words.size() != 3) throw std::invalid_argument("usage: load GRAPH FILE");
+            load(words[1], words[2]);
+            auto loaded = graph(words[1]);
+            return "ok " + std::to_string(loaded->n()) + " " + std::to_string(loaded->m());
+        }
+        if (command == "graphs") {
+            std::shared_lock lock(_graphsMutex);
+            std::string response = "ok";
+            for (const auto& [name, graph] : _graphs) {
+                response += " " + name + ":" + std::to_string(graph->n()) + ":" + std::to_string(graph->m());
+            }
+            return response;
+        }
+        if (command == "ping") {
+            return "ok";
+        }
+        if (command == "shutdown") {
+            stop();
+            return "ok";
+        }
+        throw std::invalid_argument("unknown request: " + command);
+    } catch (const std::exception& e) {
+        return std::string("error ") + e.what();
+    }
+}
+
+std::string EstimateServer::estimate(const std::vector<std::string>& words)
+{
+    if (words.size() < 4 or words.size() > 6) {
+        throw std::invalid_argument("usage: estimate GRAPH ALGORITHM K [S [REPS]]");
+    }
+    static const auto timerId = ScopedTimer::intern("EstimateServer::estimate");
+    ScopedTimer t(timerId);
+    const auto start = std::chrono::steady_clock::now();
+
+    auto graph = this->graph(words[1]);
+    const auto algorithm = Estimator::parse(words[2]);
+    const int k = parseNumber(words[3], "k");
+    const int s = words.size() > 4 ? parseNumber(words[4], "s") : 1;
+    const int reps = words.size() > 5 ? parseNumber(words[5], "reps") : 1;
+    if (reps <= 0) throw std::invalid_argument("invalid reps: " + words[5]);
+
+    RunningStats stats;
+    EstimatorResult result;
+    for (int i = 0; i < reps; ++i) {
+        result = Estimator::run(*graph, algorithm, k, s);
+        stats.add(result.estimate.value());
+    }
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::ostringstream response;
+    if (result.exact) {
+        response << "ok " << *result.exact << " " << *result.exact << " " << *result.exact << " " << ms;
+    } else if (reps == 1 and result.samples.size() < 2) {
+        response << "ok " << result.estimate << " nan nan " << ms;
+    } else {
+        // Over the repetitions if there are several, otherwise over the samples of the one run
+        auto [low, high] = reps > 1 ? stats.confidenceInterval() : result.confidenceInterval();
+        response << "ok " << Estimate(stats.mean()) << " " << Estimate(low) << " " << Estimate(high) << " " << ms;
+    }
+    return response.str();
+}
+
+void EstimateServer::serve(const std::string& socketPath, int workers, int threads)
+{
+    workers = std::max(1, workers);
+    if (threads <= 0) threads = std::max<int>(1, std::thread::hardware_concurrency() / workers);
+    const sockaddr_un address = socketAddress(socketPath);
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        throw std::runtime_error("Could not create socket: " + std::string(std::strerror(errno)));
+    }
+    unlink(socketPath.c_str());
+    if (bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0 or listen(fd, 64) < 0) {
+        const std::string error = std::strerror(errno);
+        close(fd);
+        throw std::runtime_error("Could not listen on " + socketPath + ": " + error);
+    }
+    _stopping = false;
+    _listenFd = fd;
+
+    std::vector<std::thread> pool;
+    for (int i = 0; i < workers; ++i) {
+        pool.emplace_back([this, threads] {
+#ifdef _OPENMP
+            // The thread count of the main thread does not carry over to other threads
+            omp_set_num_threads(threads);
+#endif
+            while (true) {
+                int connection;
+                {
+                    std::unique_lock lock(_connectionsMutex);
+                    _connectionReady.wait(lock, [this] { return _stopping or not _pending.empty(); });
+                    if (_pending.empty()) return;
+                    connection = _pending.front();
+                    _pending.pop_front();
+                    _active.insert(connection);
+                }
+                serveConnection(connection);
+                {
+                    std::lock_guard lock(_connectionsMutex);
+                    _active.erase(connection);
+                }
+                close(connection);
+            }
+        });
+    }
+
+    while (not _stopping) {
+        const int connection = accept(fd, nullptr, nullptr);
+        if (connection < 0) {
+            if (errno == EINTR or errno == ECONNABORTED) continue;
+            break; // stop() shut the socket down
+        }
+        {
+            std::lock_guard lock(_connectionsMutex);
+            if (_stopping) shutdown(connection, SHUT_RD);
+            _pending.push_back(connection);
+        }
+        _connectionReady.notify_one();
+    }
+
+    stop();
+    for (auto& worker : pool) {
+        worker.join();
+    }
+    _listenFd = -1;
+    close(fd);
+    unlink(socketPath.c_str());
+}
+
+void EstimateServer::stop()
+{
+    _stopping = true;
+    const int fd = _listenFd;
+    if (fd >= 0) shutdown(fd, SHUT_RDWR); // wakes up accept()
+    {
+        // Connections end after their current request
+        std::lock_guard lock(_connectionsMutex);
+        for (int connection : _pending) shutdown(connection, SHUT_RD);
+        for (int connection : _active) shutdown(connection, SHUT_RD);
+    }
+    _connectionReady.notify_all();
+}
+
+void EstimateServer::serveConnection(int fd)
+{
+    std::string buffer, line;
+    while (readLine(fd, buffer, line)) {
+        if (line.empty()) continue;
+        if (not writeLine(fd, handle(line))) return;
+    }
+}
+
+
+EstimateClient::EstimateClient(const std::string& socketPath)
+{
+    const sockaddr_un address = socketAddress(socketPath);
+    _fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (_fd < 0 or connect(_fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0) {
+        const std::string error = std::strerror(errno);
+        if (_fd >= 0) close(_fd);
+        throw std::runtime_error("Could not connect to " + socketPath + ": " + error);
+    }
+}
+
+EstimateClient::~EstimateClient()
+{
+    close(_fd);
+}
+
+std::string EstimateClient::request(const std::string& line)
+{
+    std::string response;
+    if (not writeLine(_fd, line) or not readLine(_fd, _buffer, response)) {
+        throw std::runtime_error("Connection to the server lost.");
+    }
+    return response;
+}
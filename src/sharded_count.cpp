@@ -0,0 +1,226 @@
+#include "sharded_count.hpp"
+#include "graph.hpp"
+#include "basics/memory.hpp"
+#include "basics/timer.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+ShardedCount::MappedCSR::MappedCSR(const std::string& filename)
+{
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open file: " + filename);
+    }
+    struct stat status;
+    if (fstat(fd, &status) < 0 or status.st_size < static_cast<off_t>(sizeof(Graph::RankedCSRMagic) + 2 * sizeof(uint64_t))) {
+        close(fd);
+        throw std::runtime_error("Not a ranked CSR file: " + filename);
+    }
+    _size = status.st_size;
+    _data = mmap(nullptr, _size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (_data == MAP_FAILED) {
+        _data = nullptr;
+        throw std::runtime_error("Could not map " + filename + ": " + std::strerror(errno));
+    }
+
+    const char* bytes = static_cast<const char*>(_data);
+    const auto* header = reinterpret_cast<const uint64_t*>(bytes + sizeof(Graph::RankedCSRMagic));
+    _n = header[0];
+    _offsets = header + 2;
+    _neighbors = reinterpret_cast<const int32_t*>(_offsets + _n + 1);
+    const size_t expected = sizeof(Graph::RankedCSRMagic) + (3 + header[0]) * sizeof(uint64_t) + header[1] * sizeof(int32_t);
+    if (not std::equal(bytes, bytes + sizeof(Graph::RankedCSRMagic), Graph::RankedCSRMagic) or _size != expected) {
+        munmap(_data, _size);
+        _data = nullptr;
+        throw std::runtime_error("Not a ranked CSR file: " + filename);
+    }
+}
+
+ShardedCount::MappedCSR::~MappedCSR()
+{
+    if (_data) munmap(_data, _size);
+}
+
+std::vector<int> ShardedCount::shardBounds(const MappedCSR& csr, int shards)
+{
+    if (shards <= 0) throw std::invalid_argument("invalid number of shards");
+    // The wedges of u are bounded by the degrees of its lower ranked neighbors
+    const int n = csr.n();
+    const uint64_t* offsets = csr.offsets();
+    std::vector<long long> work(n + 1, 0);
+    for (int u = 0; u < n; ++u) {
+        long long wedges = 0;
+        for (uint64_t i = offsets[u]; i < offsets[u + 1]; ++i) {
+            const int v = csr.neighbors()[i];
+            if (v >= u) break;
+            wedges += offsets[v + 1] - offsets[v];
+        }
+        work[u + 1] = work[u] + wedges + 1;
+    }
+    std::vector<int> bounds(shards + 1, n);
+    bounds[0] = 0;
+    for (int i = 1; i < shards; ++i) {
+        const long double target = static_cast<long double>(work[n]) * i / shards;
+        bounds[i] = std::lower_bound(work.begin(), work.end(), target) - work.begin();
+        bounds[i] = std::clamp(bounds[i], bounds[i - 1], n);
+    }
+    return bounds;
+}
+
+c4count ShardedCount::countRanks(const std::string& csrFile, int from, int to)
+{
+    static const auto timerId = ScopedTimer::intern("ShardedCount::countRanks");
+    ScopedTimer t1(timerId);
+    const MappedCSR csr(csrFile);
+    const int n = csr.n();
+    if (from < 0 or from > to or to > n) throw std::invalid_argument("invalid range of ranks");
+    const uint64_t* offsets = csr.offsets();
+    const int32_t* neighbors = csr.neighbors();
+    c4count totalC4 = 0;
+    size_t scratchBytes = 0;
+
+    // Wedges u-v-w with v, w < u, as in countFourCycles()
+    #pragma omp parallel
+    {
+        c4count threadC4 = 0;
+        std::vector<int> wedges(n, 0);
+        std::vector<int> touched;
+
+        #pragma omp for schedule(dynamic, 64)
+        for (int u = from; u < to; ++u) {
+            for (uint64_t i = offsets[u]; i < offsets[u + 1]; ++i) {
+                const int v = neighbors[i];
+                if (v >= u) break;
+                for (uint64_t j = offsets[v]; j < offsets[v + 1]; ++j) {
+                    const int w = neighbors[j];
+                    if (w >= u) break;
+                    if (wedges[w]++ == 0) touched.push_back(w);
+                }
+            }
+            for (int w : touched) {
+                const long long c = wedges[w];
+                threadC4 += c * (c - 1) / 2;
+                wedges[w] = 0;
+            }
+            touched.clear();
+        }
+
+        #pragma omp critical
+        {
+            totalC4 += threadC4;
+            scratchBytes += Memory::of(wedges) + Memory::of(touched);
+        }
+    }
+    MemoryTracker::record("ShardedCount::countRanks", scratchBytes);
+    return totalC4;
+}
+
+static c4count parseCount(const std::string& text)
+{
+    c4count value = 0;
+    size_t digits = 0;
+    for (char c : text) {
+        if (c == '\n') break;
+        if (c < '0' or c > '9') throw std::runtime_error("Unexpected worker output: " + text);
+        value = value * 10 + (c - '0');
+        digits++;
+    }
+    if (digits == 0) throw std::runtime_error("Unexpected worker output: " + text);
+    return value;
+}
+
+// Kills and reaps the workers started so far, so that a failed start leaves no processes behind
+static void stopWorkers(const std::vector<pid_t>& workers, const std::vector<int>& outputs)
+{
+    for (size_t i = 0; i < workers.size(); ++i) {
+        kill(workers[i], SIGKILL);
+        close(outputs[i]);
+        while (waitpid(workers[i], nullptr, 0) < 0 and errno == EINTR) {}
+    }
+}
+
+c4count ShardedCount::run(const std::vector<std::string>& workerCommand, const std::vector<int>& bounds)
+{
+    static const auto timerId = ScopedTimer::intern("ShardedCount::run");
+    ScopedTimer t1(timerId);
+    if (workerCommand.empty()) throw std::invalid_argument("no worker command");
+    if (bounds.size() < 2) throw std::invalid_argument("invalid number of shards");
+    const int shards = bounds.size() - 1;
+
+    std::vector<pid_t> workers;
+    std::vector<int> outputs;
+    for (int shard = 0; shard < shards; ++shard) {
+        std::vector<std::string> arguments = workerCommand;
+        arguments.push_back("--shard");
+        arguments.push_back(std::to_string(shard));
+        arguments.push_back("--from");
+        arguments.push_back(std::to_string(bounds[shard]));
+        arguments.push_back("--to");
+        arguments.push_back(std::to_string(bounds[shard + 1]));
+        std::vector<char*> argv;
+        for (auto& argument : arguments) argv.push_back(argument.data());
+        argv.push_back(nullptr);
+
+        int pipeFds[2];
+        if (pipe2(pipeFds, O_CLOEXEC) < 0) {
+            const std::string message = std::strerror(errno);
+            stopWorkers(workers, outputs);
+            throw std::runtime_error("Could not create pipe: " + message);
+        }
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_adddup2(&actions, pipeFds[1], STDOUT_FILENO);
+        posix_spawn_file_actions_addclose(&actions, pipeFds[0]);
+        pid_t pid;
+        const int error = posix_spawn(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+        posix_spawn_file_actions_destroy(&actions);
+        close(pipeFds[1]);
+        if (error != 0) {
+            close(pipeFds[0]);
+            stopWorkers(workers, outputs);
+            throw std::runtime_error("Could not start worker " + arguments[0] + ": " + std::strerror(error));
+        }
+        workers.push_back(pid);
+        outputs.push_back(pipeFds[0]);
+    }
+
+    // Workers run concurrently and print a single line each
+    std::vector<std::string> counts(shards);
+    std::string failure;
+    for (int shard = 0; shard < shards; ++shard) {
+        std::string& output = counts[shard];
+        char buffer[256];
+        ssize_t received;
+        while ((received = read(outputs[shard], buffer, sizeof(buffer))) != 0) {
+            if (received < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            output.append(buffer, received);
+        }
+        close(outputs[shard]);
+        int status = 0;
+        while (waitpid(workers[shard], &status, 0) < 0 and errno == EINTR) {}
+        if (not WIFEXITED(status) or WEXITSTATUS(status) != 0) {
+            if (failure.empty()) failure = "Worker for shard " + std::to_string(shard) + " failed.";
+        }
+    }
+    if (not failure.empty()) throw std::runtime_error(failure);
+    c4count total = 0;
+    for (const auto& count : counts) {
+        total += parseCount(count);
+    }
+    return total;
+}
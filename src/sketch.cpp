@@ -0,0 +1,91 @@
+#include "sketch.hpp"
+#include "basics/serialize.hpp"
+#include "basics/timer.hpp"
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+Sketch::Sketch(int k, int s, uint64_t hashSeed) : _eis(k, s), _nis(k, hashSeed)
+{
+    if (k <= 0) throw std::invalid_argument("invalid k");
+    if (s <= 0 or s > k) throw std::invalid_argument("invalid s");
+}
+
+Sketch::Sketch(const std::string& filename) : _eis(1, 1), _nis(1)
+{
+    std::ifstream in(filename, std::ios::binary);
+    if (!in.is_open()) {
+        throw std::runtime_error("Could not open file: " + filename);
+    }
+    char magic[sizeof(Magic)];
+    in.read(magic, sizeof(magic));
+    if (!in or not std::equal(magic, magic + sizeof(magic), Magic)) {
+        throw std::runtime_error("Not a sketch: " + filename);
+    }
+    _phase = static_cast<Phase>(Binary::read<uint8_t>(in));
+    _eis.read(in);
+    _nis.read(in);
+}
+
+void Sketch::write(const std::string& filename) const
+{
+    std::ofstream out(filename, std::ios::binary);
+    if (!out.is_open()) {
+        throw std::runtime_error("Could not open file: " + filename);
+    }
+    out.write(Magic, sizeof(Magic));
+    Binary::write<uint8_t>(out, static_cast<uint8_t>(_phase));
+    _eis.write(out);
+    _nis.write(out);
+    if (!out) {
+        throw std::runtime_error("Could not write file: " + filename);
+    }
+}
+
+void Sketch::sample(EdgeStream& stream)
+{
+    static const auto timerId = ScopedTimer::intern("Sketch::sample");
+    ScopedTimer t(timerId);
+    if (_phase != Phase::Sampled) throw std::logic_error("Sketch already past its first pass.");
+    // Reservoirs of k/s edges even if the shard is smaller, so that all shards can be merged
+    _eis.begin(std::numeric_limits<long long>::max());
+    stream.rewind();
+    for (auto block = stream.nextBlock(); not block.empty(); block = stream.nextBlock()) {
+        _eis.firstPass(block);
+        _nis.firstPass(block);
+    }
+}
+
+void Sketch::induce(EdgeStream& stream)
+{
+    static const auto timerId = ScopedTimer::intern("Sketch::induce");
+    ScopedTimer t(timerId);
+    if (_phase != Phase::Sampled) throw std::logic_error("Sketch already past its first pass.");
+    _eis.endFirstPass();
+    stream.rewind();
+    for (auto block = stream.nextBlock(); not block.empty(); block = stream.nextBlock()) {
+        _eis.secondPass(block);
+    }
+    _phase = Phase::Induced;
+}
+
+void Sketch::merge(const Sketch& other)
+{
+    static const auto timerId = ScopedTimer::intern("Sketch::merge");
+    ScopedTimer t(timerId);
+    if (_phase != other._phase) throw std::invalid_argument("Cannot merge sketches of different phases.");
+    _eis.merge(other._eis);
+    if (_phase == Phase::Sampled) _nis.merge(other._nis);
+}
+
+EstimatorResult Sketch::estimateEIS()
+{
+    if (_phase != Phase::Induced) throw std::logic_error("EIS needs the second pass of all shards.");
+    return _eis.estimate();
+}
+
+EstimatorResult Sketch::estimateNIS()
+{
+    return _nis.estimate();
+}
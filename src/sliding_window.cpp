@@ -0,0 +1,106 @@
+#include "sliding_window.hpp"
+#include "basics/memory.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+SlidingWindowEstimator::SlidingWindowEstimator(long long window, int k) : _window(window), _k(k)
+{
+    if (window <= 0) throw std::invalid_argument("invalid window");
+}
+
+uint64_t SlidingWindowEstimator::key(Graph::node u, Graph::node v)
+{
+    if (u > v) std::swap(u, v);
+    return (static_cast<uint64_t>(static_cast<uint32_t>(u)) << 32) | static_cast<uint32_t>(v);
+}
+
+void SlidingWindowEstimator::insert(Graph::node u, Graph::node v, long long timestamp)
+{
+    if (not _arrivals.empty() and timestamp < _arrivals.back().first) {
+        throw std::invalid_argument("Edges out of timestamp order.");
+    }
+    advance(timestamp);
+    if (_arrivals.empty() or _arrivals.back().first != timestamp) {
+        _arrivals.emplace_back(timestamp, 0);
+    }
+    _arrivals.back().second++;
+    _windowEdges++;
+
+    if (u == v) return;
+    const uint32_t score = std::max(_tabHash.Simple(u), _tabHash.Simple(v));
+    if (score > _threshold) return;
+
+    _sampled.push_back({timestamp, u, v, score});
+    if (_copies[key(u, v)]++ > 0) return; // already in the sample
+    addSampleEdge(u, v);
+    _byScore.insert({score, key(u, v)});
+
+    // Drop all edges with the largest score until the sample fits again
+    while (_k > 0 and _byScore.size() > static_cast<size_t>(_k)) {
+        const uint32_t maxScore = _byScore.rbegin()->first;
+        for (auto it = _byScore.lower_bound({maxScore, 0}); it != _byScore.end(); it = _byScore.erase(it)) {
+            removeSampleEdge(it->second >> 32, static_cast<uint32_t>(it->second));
+            _copies.erase(it->second);
+        }
+        _threshold = maxScore - 1;
+    }
+}
+
+void SlidingWindowEstimator::advance(long long time)
+{
+    while (not _arrivals.empty() and _arrivals.front().first <= time - _window) {
+        _windowEdges -= _arrivals.front().second;
+        _arrivals.pop_front();
+    }
+    while (not _sampled.empty() and _sampled.front().timestamp <= time - _window) {
+        const Arrival arrival = _sampled.front();
+        _sampled.pop_front();
+        if (arrival.score > _threshold) continue; // dropped from the sample when the threshold fell
+        auto it = _copies.find(key(arrival.u, arrival.v));
+        if (--it->second > 0) continue; // a later copy is still in the window
+        _copies.erase(it);
+        _byScore.erase({arrival.score, key(arrival.u, arrival.v)});
+        removeSampleEdge(arrival.u, arrival.v);
+    }
+}
+
+Estimate SlidingWindowEstimator::estimate() const
+{
+    const long double p = (_threshold + 1.0L) / 4294967296.0L;
+    return static_cast<long double>(_sample.fourCycles()) / p / p / p / p;
+}
+
+Graph::node SlidingWindowEstimator::sampleId(Graph::node u)
+{
+    // Ids handed out so far are either in use or free
+    auto [it, inserted] = _sampleIds.try_emplace(u, _sampleIds.size() + _freeIds.size());
+    if (inserted and not _freeIds.empty()) {
+        it->second = _freeIds.back();
+        _freeIds.pop_back();
+    }
+    return it->second;
+}
+
+void SlidingWindowEstimator::addSampleEdge(Graph::node u, Graph::node v)
+{
+    _sample.insertEdge(sampleId(u), sampleId(v));
+}
+
+void SlidingWindowEstimator::removeSampleEdge(Graph::node u, Graph::node v)
+{
+    auto itU = _sampleIds.find(u);
+    auto itV = _sampleIds.find(v);
+    _sample.deleteEdge(itU->second, itV->second);
+    // Ids of nodes without sampled edges are reused, which keeps the sample graph as small as the sample
+    for (auto it : {itU, itV}) {
+        if (_sample.degree(it->second) > 0) continue;
+        _freeIds.push_back(it->second);
+        _sampleIds.erase(it);
+    }
+}
+
+size_t SlidingWindowEstimator::memory_usage() const
+{
+    return Memory::of(_arrivals) + Memory::of(_sampled) + Memory::of(_copies) + Memory::of(_byScore)
+        + _sample.memory_usage() + Memory::of(_sampleIds) + Memory::of(_freeIds);
+}
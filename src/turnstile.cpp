@@ -0,0 +1,234 @@
+#include "turnstile.hpp"
+#include "EIS_sample.hpp"
+#include "fused_estimators.hpp"
+#include "basics/memory.hpp"
+#include "basics/random.hpp"
+#include "basics/report.hpp"
+#include "basics/timer.hpp"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+RandomPairingReservoir::RandomPairingReservoir(int capacity) : _capacity(capacity), _gen(Seeds::next())
+{
+    if (capacity <= 0) throw std::invalid_argument("invalid reservoir capacity");
+    _edges.reserve(capacity);
+}
+
+uint64_t RandomPairingReservoir::key(Graph::node u, Graph::node v)
+{
+    if (u > v) std::swap(u, v);
+    return (static_cast<uint64_t>(static_cast<uint32_t>(u)) << 32) | static_cast<uint32_t>(v);
+}
+
+void RandomPairingReservoir::add(const Graph::edge& edge)
+{
+    _position[key(edge.first, edge.second)] = _edges.size();
+    _edges.push_back(edge);
+}
+
+void RandomPairingReservoir::update(const EdgeUpdate& update)
+{
+    const Graph::edge edge{update.u, update.v};
+    if (update.sign < 0) {
+        _size--;
+        auto it = _position.find(key(update.u, update.v));
+        if (it == _position.end()) {
+            _unsampledDeletions++;
+            return;
+        }
+        // Fill the slot with the last sampled edge
+        const size_t slot = it->second;
+        _position.erase(it);
+        if (slot + 1 != _edges.size()) {
+            _edges[slot] = _edges.back();
+            _position[key(_edges[slot].first, _edges[slot].second)] = slot;
+        }
+        _edges.pop_back();
+        _sampledDeletions++;
+        return;
+    }
+
+    _size++;
+    const long long deletions = _sampledDeletions + _unsampledDeletions;
+    if (deletions == 0) {
+        // Reservoir sampling as long as no deletion needs to be compensated
+        if (_edges.size() < static_cast<size_t>(_capacity)) {
+            add(edge);
+            return;
+        }
+        std::uniform_int_distribution<long long> dist(0, _size - 1);
+        const long long index = dist(_gen);
+        if (index < _capacity) {
+            const Graph::edge& replaced = _edges[index];
+            _position.erase(key(replaced.first, replaced.second));
+            _position[key(edge.first, edge.second)] = index;
+            _edges[index] = edge;
+        }
+        return;
+    }
+    // Pairs the insertion with an earlier deletion, inside the sample with the share of sampled deletions
+    std::uniform_int_distribution<long long> dist(0, deletions - 1);
+    if (dist(_gen) < _sampledDeletions) {
+        add(edge);
+        _sampledDeletions--;
+    } else {
+        _unsampledDeletions--;
+    }
+}
+
+size_t RandomPairingReservoir::memory_usage() const
+{
+    return Memory::of(_edges) + Memory::of(_position);
+}
+
+
+uint64_t TurnstileStream::key(Graph::node u, Graph::node v)
+{
+    if (u > v) std::swap(u, v);
+    return (static_cast<uint64_t>(static_cast<uint32_t>(u)) << 32) | static_cast<uint32_t>(v);
+}
+
+void TurnstileStream::read(const std::string& filename)
+{
+    if (filename == "-") {
+        read(std::cin);
+        return;
+    }
+    std::ifstream infile(filename);
+    if (!infile.is_open()) {
+        throw std::runtime_error("Could not open file: " + filename);
+    }
+    read(infile);
+}
+
+void TurnstileStream::read(std::istream& in)
+{
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() or line[0] == '%') continue;
+        std::istringstream iss(line);
+        int u, v, sign;
+        if (!(iss >> u >> v >> sign)) {
+            throw std::runtime_error("Expected \"u v sign\": " + line);
+        }
+        addUpdate(u - 1, v - 1, sign); // 0-based
+    }
+}
+
+void TurnstileStream::addUpdate(Graph::node u, Graph::node v, int sign)
+{
+    if (u < 0 or v < 0) throw std::out_of_range("Node index out of range.");
+    if (sign != 1 and sign != -1) throw std::invalid_argument("The sign of an update must be +1 or -1.");
+    if (u == v) return;
+    _n = std::max({_n, u + 1, v + 1});
+    const uint64_t k = key(u, v);
+    if (sign > 0) {
+        if (not _edges.emplace(k, Graph::edge{u, v}).second) {
+            throw std::runtime_error("Insertion of an edge already in the graph.");
+        }
+        _updates.push_back({u, v, 1});
+    } else {
+        auto it = _edges.find(k);
+        if (it == _edges.end()) {
+            throw std::runtime_error("Deletion of an edge not in the graph.");
+        }
+        // Same orientation as the insertion
+        _updates.push_back({it->second.first, it->second.second, -1});
+        _edges.erase(it);
+    }
+}
+
+Graph TurnstileStream::finalGraph() const
+{
+    Graph graph;
+    for (const auto& [k, edge] : _edges) {
+        graph.addEdge(edge.first, edge.second, true);
+    }
+    return graph;
+}
+
+EstimatorResult TurnstileStream::EIS(int k, int s) const
+{
+    const int space = k / s;
+    std::vector<Sample> samples(s);
+    {
+        static const auto firstPassTimer = ScopedTimer::intern("TurnstileStream::EIS::1st-pass");
+        ScopedTimer t(firstPassTimer);
+        std::vector<RandomPairingReservoir> reservoirs;
+        for (int i = 0; i < s; ++i) {
+            reservoirs.emplace_back(space);
+        }
+        for (const auto& update : _updates) {
+            for (auto& reservoir : reservoirs) {
+                reservoir.update(update);
+            }
+        }
+        for (int i = 0; i < s; ++i) {
+            samples[i].setupFromReservoir(reservoirs[i].edges(), space, reservoirs[i].streamSize());
+        }
+    }
+    {
+        static const auto secondPassTimer = ScopedTimer::intern("TurnstileStream::EIS::2nd-pass");
+        ScopedTimer t(secondPassTimer);
+        for (const auto& update : _updates) {
+            for (auto& sample : samples) {
+                sample.collectInducedUpdate({update.u, update.v}, update.sign);
+            }
+        }
+    }
+    return EISConsumer::combine(samples, nullptr);
+}
+
+EstimatorResult TurnstileStream::NIS(int k) const
+{
+    static const auto timerId = ScopedTimer::intern("TurnstileStream::NIS");
+    ScopedTimer t(timerId);
+    NISConsumer nis(k);
+    for (const auto& update : _updates) {
+        if (update.sign > 0) {
+            nis.insert({update.u, update.v});
+        } else {
+            nis.erase({update.u, update.v});
+        }
+    }
+    return nis.estimate();
+}
+
+EstimatorResult TurnstileStream::multipass_baseline(int k) const
+{
+    static const auto timerId = ScopedTimer::intern("TurnstileStream::multipass_baseline");
+    ScopedTimer t(timerId);
+    RandomPairingReservoir reservoir(k);
+    for (const auto& update : _updates) {
+        reservoir.update(update);
+    }
+
+    Graph sampleGraph;
+    std::unordered_map<int, int> sampleNodes;
+    Graph::node nextNode = 0;
+    for (const auto& [u, v] : reservoir.edges()) {
+        auto [itU, insertedU] = sampleNodes.try_emplace(u, nextNode);
+        if (insertedU) nextNode++;
+        auto [itV, insertedV] = sampleNodes.try_emplace(v, nextNode);
+        if (insertedV) nextNode++;
+        sampleGraph.addEdge(itU->second, itV->second, true);
+    }
+
+    // A deleted edge takes back the four-cycles it completed when inserted
+    c4count sampleCount = 0;
+    for (const auto& update : _updates) {
+        auto itU = sampleNodes.find(update.u);
+        if (itU == sampleNodes.end()) continue; // not induced
+        auto itV = sampleNodes.find(update.v);
+        if (itV == sampleNodes.end()) continue;
+        sampleCount += update.sign * sampleGraph.countSquaresCompletedByEdge(itU->second, itV->second);
+    }
+
+    MemoryTracker::record("multipass_baseline::sample", reservoir.memory_usage() + Memory::of(sampleNodes) + sampleGraph.memory_usage());
+    RunReport::addSample({sampleGraph.m(), 0, 0, 0});
+    double prob = m() > 0 ? 1.0 * sampleGraph.m() / m() : 0;
+
+    Estimate estimate = prob > 0 ? static_cast<long double>(sampleCount)/prob/prob/prob/4 : 0;
+    return estimate;
+}